@@ -0,0 +1,91 @@
+//============================================================================
+// Name        : AllocationCounter.cpp
+// Description : heap allocations made by the calling thread, for checks
+//============================================================================
+
+#include "AllocationCounter.hpp"
+
+#ifdef FAZERCHOVER_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local uint64_t allocations = 0;
+
+    void* allocate(std::size_t size)
+    {
+        ++allocations;
+        void* p = std::malloc(size ? size : 1);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+bool AllocationCounter::isEnabled()
+{
+    return true;
+}
+
+uint64_t AllocationCounter::getCount()
+{
+    return allocations;
+}
+
+#else
+
+bool AllocationCounter::isEnabled()
+{
+    return false;
+}
+
+uint64_t AllocationCounter::getCount()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,22 @@
+//============================================================================
+// Name        : AllocationCounter.hpp
+// Description : heap allocations made by the calling thread, for checks
+//============================================================================
+
+#ifndef ALLOCATIONCOUNTER_INCLUDE
+#define ALLOCATIONCOUNTER_INCLUDE
+
+#include <stdint.h>
+
+// Built with FAZERCHOVER_COUNT_ALLOCATIONS defined, AllocationCounter.cpp
+// replaces the global operator new and counts every allocation per thread.
+// Code that promises not to allocate compares getCount() around its work.
+// In normal builds nothing is replaced, isEnabled() is false and the count
+// stays 0.
+namespace AllocationCounter
+{
+    bool isEnabled();
+    uint64_t getCount();
+}
+
+#endif // ALLOCATIONCOUNTER_INCLUDE
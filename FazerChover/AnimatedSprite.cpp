@@ -22,6 +22,7 @@
 ////////////////////////////////////////////////////////////
 
 #include "AnimatedSprite.hpp"
+#include <algorithm>
 #include <cmath>
 namespace stdmath
 {
@@ -41,7 +42,7 @@ namespace stdmath {
 
 
 AnimatedSprite::AnimatedSprite(sf::Time frameTime, bool paused, bool looped) :
-m_animation(NULL), m_frameTime(frameTime), m_currentFrame(0), m_isPaused(paused), m_isLooped(looped), m_texture(NULL)
+m_animation(NULL), m_frameTime(frameTime), m_currentFrame(0), maxIteration(0), currentIteration(0), m_isPaused(paused), m_isLooped(looped), m_playReverse(false), m_texture(NULL)
 {
 
 }
@@ -52,6 +53,8 @@ void AnimatedSprite::setAnimation(const Animation& animation)
 {
     m_animation = &animation;
     m_texture = m_animation->getSpriteSheet();
+    if (m_animation->getFrameTime() != sf::Time::Zero)
+        m_frameTime = m_animation->getFrameTime();
     m_currentFrame = 0;
     currentIteration = 0;
     maxIteration = 0;
@@ -88,6 +91,7 @@ void AnimatedSprite::restart()
     currentIteration = 1;
     maxIteration = 0;
     m_currentFrame = 0;
+    m_currentTime = sf::Time::Zero;
 }
 
 
@@ -99,6 +103,16 @@ void AnimatedSprite::stop()
 }
 void AnimatedSprite::setPlayReverse(bool value)
 {
+    // inside a held frame, mirror the elapsed time so the position is kept
+    if (value != m_playReverse && m_animation && m_currentFrame < m_animation->getFrameCount())
+    {
+        std::size_t steps = getHeldSteps();
+        sf::Time fraction = m_currentTime - m_frameTime * static_cast<sf::Int64>(steps);
+        if (fraction < sf::Time::Zero)
+            fraction = sf::Time::Zero;
+        std::size_t hold = m_animation->getFrameHold(m_currentFrame);
+        m_currentTime = m_frameTime * static_cast<sf::Int64>(hold - 1 - steps) + fraction;
+    }
     m_playReverse = value;
 }
 
@@ -127,10 +141,12 @@ sf::FloatRect AnimatedSprite::getLocalBounds() const
 {
     sf::IntRect rect = m_animation->getFrame(m_currentFrame);
     
+    sf::Vector2f offset = m_animation->getFrameOffset(m_currentFrame);
+    
     float width = static_cast<float>(stdmath::abs(rect.width));
     float height = static_cast<float>(stdmath::abs(rect.height));
     
-    return sf::FloatRect(0.f, 0.f, width, height);
+    return sf::FloatRect(offset.x, offset.y, width, height);
 }
 
 sf::FloatRect AnimatedSprite::getGlobalBounds() const
@@ -155,7 +171,22 @@ bool AnimatedSprite::isPlaying() const
 
 std::size_t AnimatedSprite::getCurrentFrame() const
 {
-    return m_currentFrame;
+    if (!m_animation || m_currentFrame >= m_animation->getFrameCount())
+        return m_currentFrame;
+    
+    std::size_t start = m_animation->getFrameStart(m_currentFrame);
+    std::size_t steps = getHeldSteps();
+    if (m_playReverse)
+        return start + m_animation->getFrameHold(m_currentFrame) - 1 - steps;
+    return start + steps;
+}
+
+std::size_t AnimatedSprite::getHeldSteps() const
+{
+    if (m_frameTime <= sf::Time::Zero)
+        return 0;
+    std::size_t steps = static_cast<std::size_t>(m_currentTime.asMicroseconds() / m_frameTime.asMicroseconds());
+    return std::min(steps, m_animation->getFrameHold(m_currentFrame) - 1);
 }
 
 sf::Time AnimatedSprite::getFrameTime() const
@@ -171,79 +202,119 @@ void AnimatedSprite::setMaxIteration(int value)
 
 void AnimatedSprite::setFrame(std::size_t newFrame, bool resetTime)
 {
-    if (m_animation)
+    if (m_animation && m_animation->getFrameCount() > 0)
     {
-        //calculate new vertex positions and texture coordiantes
-        sf::IntRect rect = m_animation->getFrame(newFrame);
-        
-        m_vertices[0].position = sf::Vector2f(0.f, 0.f);
-        m_vertices[1].position = sf::Vector2f(0.f, static_cast<float>(rect.height));
-        m_vertices[2].position = sf::Vector2f(static_cast<float>(rect.width), static_cast<float>(rect.height));
-        m_vertices[3].position = sf::Vector2f(static_cast<float>(rect.width), 0.f);
+        std::size_t frame = std::min(m_animation->getFrameIndex(newFrame), m_animation->getFrameCount() - 1);
+        if (frame != m_currentFrame || resetTime)
+            setVertices(frame);
+        m_currentFrame = frame;
         
-        float left = static_cast<float>(rect.left) + 0.0001f;
-        float right = left + static_cast<float>(rect.width);
-        float top = static_cast<float>(rect.top);
-        float bottom = top + static_cast<float>(rect.height);
-        
-        m_vertices[0].texCoords = sf::Vector2f(left, top);
-        m_vertices[1].texCoords = sf::Vector2f(left, bottom);
-        m_vertices[2].texCoords = sf::Vector2f(right, bottom);
-        m_vertices[3].texCoords = sf::Vector2f(right, top);
+        if (resetTime)
+        {
+            // start inside the held frame at the requested position
+            std::size_t start = m_animation->getFrameStart(frame);
+            std::size_t hold = m_animation->getFrameHold(frame);
+            std::size_t steps = std::min(newFrame - std::min(newFrame, start), hold - 1);
+            if (m_playReverse)
+                steps = hold - 1 - steps;
+            m_currentTime = m_frameTime * static_cast<sf::Int64>(steps);
+        }
     }
-    
-    if (resetTime)
+    else if (resetTime)
         m_currentTime = sf::Time::Zero;
 }
 
+void AnimatedSprite::setVertices(std::size_t frame)
+{
+    //calculate new vertex positions and texture coordiantes
+    sf::IntRect rect = m_animation->getFrame(frame);
+    sf::Vector2f offset = m_animation->getFrameOffset(frame);
+    
+    //frames trimmed by the atlas packer keep their place inside the original cell
+    m_vertices[0].position = offset;
+    m_vertices[1].position = offset + sf::Vector2f(0.f, static_cast<float>(rect.height));
+    m_vertices[2].position = offset + sf::Vector2f(static_cast<float>(rect.width), static_cast<float>(rect.height));
+    m_vertices[3].position = offset + sf::Vector2f(static_cast<float>(rect.width), 0.f);
+    
+    float left = static_cast<float>(rect.left) + 0.0001f;
+    float right = left + static_cast<float>(rect.width);
+    float top = static_cast<float>(rect.top);
+    float bottom = top + static_cast<float>(rect.height);
+    
+    m_vertices[0].texCoords = sf::Vector2f(left, top);
+    m_vertices[1].texCoords = sf::Vector2f(left, bottom);
+    m_vertices[2].texCoords = sf::Vector2f(right, bottom);
+    m_vertices[3].texCoords = sf::Vector2f(right, top);
+}
+
 bool AnimatedSprite::update(sf::Time deltaTime)
 {
     // if not paused and we have a valid animation
-    if (!m_isPaused && m_animation)
+    if (!m_isPaused && m_animation && m_animation->getFrameCount() > 0 && m_frameTime > sf::Time::Zero)
     {
         // add delta time
         m_currentTime += deltaTime;
         
-        // if current time is bigger then the frame time advance one frame
-        if (m_currentTime >= m_frameTime)
+        // a held frame is left alone until its whole hold has passed
+        if (m_currentTime >= m_frameTime * static_cast<sf::Int64>(m_animation->getFrameHold(m_currentFrame)))
         {
-            // reset time, but keep the remainder
-            m_currentTime = sf::microseconds(m_currentTime.asMicroseconds() % m_frameTime.asMicroseconds());
+            // a long delta skips every frame it spans, so playback keeps real time
+            sf::Int64 frameTime = m_frameTime.asMicroseconds();
+            sf::Int64 length = static_cast<sf::Int64>(m_animation->getSize());
+            sf::Int64 elapsed = static_cast<sf::Int64>(getPlayStart(m_currentFrame)) * frameTime + m_currentTime.asMicroseconds();
+            sf::Int64 steps = elapsed / frameTime;
+            std::size_t previousFrame = m_currentFrame;
             
-            // get next Frame index
-            if (m_playReverse){
-                if(m_currentFrame > 0){
-                    m_currentFrame--;
-                } else {
-                    if (!m_isLooped){
-                        m_isPaused = true;
-                    } else {
-                        m_currentFrame = (m_animation->getSize()-1); // reset to end
-                        currentIteration++;
-                    }
-                }
-            } else {
-                if (m_currentFrame + 1 < m_animation->getSize()){
-                    m_currentFrame++;
-                } else {
-                    // animation has ended
-                    if (!m_isLooped){
-                        m_isPaused = true;
-                    } else {
-                        m_currentFrame = 0; // reset to start
-                        currentIteration++;
-                    }
+            if (steps >= length && !m_isLooped)
+            {
+                // animation has ended, stay on the last position
+                m_isPaused = true;
+                m_currentFrame = m_playReverse ? 0 : m_animation->getFrameCount() - 1;
+                sf::Int64 hold = static_cast<sf::Int64>(m_animation->getFrameHold(m_currentFrame));
+                m_currentTime = sf::microseconds((hold - 1) * frameTime + elapsed % frameTime);
+            }
+            else
+            {
+                if (steps >= length)
+                {
+                    // reset to start, once per pass over the animation
+                    currentIteration += static_cast<std::size_t>(steps / length);
+                    elapsed %= length * frameTime;
+                    steps = elapsed / frameTime;
                 }
+                std::size_t position = static_cast<std::size_t>(m_playReverse ? length - 1 - steps : steps);
+                m_currentFrame = m_animation->getFrameIndex(position);
+                m_currentTime = sf::microseconds(elapsed - static_cast<sf::Int64>(getPlayStart(m_currentFrame)) * frameTime);
             }
             
-            // set the current frame, not reseting the time
-            setFrame(m_currentFrame, false);
+            // only a new frame needs new vertices
+            if (m_currentFrame != previousFrame)
+                setVertices(m_currentFrame);
         }
     }
     
     return currentIteration > maxIteration;
 }
 
+std::size_t AnimatedSprite::getPlayStart(std::size_t frame) const
+{
+    if (m_playReverse)
+        return m_animation->getSize() - m_animation->getFrameStart(frame) - m_animation->getFrameHold(frame);
+    return m_animation->getFrameStart(frame);
+}
+
+const sf::Texture* AnimatedSprite::getTexture() const
+{
+    return m_animation ? m_texture : NULL;
+}
+
+void AnimatedSprite::appendQuad(sf::VertexArray& vertices) const
+{
+    const sf::Transform& transform = getTransform();
+    for (int i = 0; i < 4; i++)
+        vertices.append(sf::Vertex(transform.transformPoint(m_vertices[i].position), m_vertices[i].color, m_vertices[i].texCoords));
+}
+
 void AnimatedSprite::draw(sf::RenderTarget& target, sf::RenderStates states) const
 {
     if (m_animation && m_texture)
@@ -28,10 +28,9 @@
 #include <SFML/System/Time.hpp>
 #include <SFML/Graphics/Drawable.hpp>
 #include <SFML/Graphics/Transformable.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
 #include <SFML/System/Vector2.hpp>
 
-#include <SFML/Window/Event.hpp>
-
 #include "Animation.hpp"
 
 
@@ -43,8 +42,7 @@ class AnimatedSprite : public sf::Drawable, public sf::Transformable
 public:
     explicit AnimatedSprite(sf::Time frameTime = sf::seconds(0.2f), bool paused = false, bool looped = true);
     
-    sf::Event event;
-    
+    // advances by every frame time deltaTime spans, however long
     bool update(sf::Time deltaTime);
     void setAnimation(const Animation& animation);
     void setFrameTime(sf::Time time);
@@ -63,9 +61,13 @@ public:
     bool isPlaying() const;
     bool isPlayingReverse() const;
     sf::Time getFrameTime() const;
+    // position in frame times, counting the holds of the animation
     std::size_t getCurrentFrame() const;
     void setFrame(std::size_t newFrame, bool resetTime = true);
     void setMaxIteration(int value);
+    const sf::Texture* getTexture() const;
+    // appends the transformed quad, for drawing through a SpriteBatch
+    void appendQuad(sf::VertexArray& vertices) const;
     
 private:
     const Animation* m_animation;
@@ -80,6 +82,12 @@ private:
     const sf::Texture* m_texture;
     sf::Vertex m_vertices[4];
     
+    std::size_t getHeldSteps() const;
+    // position in frame times where a frame begins, counted in the
+    // direction of play
+    std::size_t getPlayStart(std::size_t frame) const;
+    void setVertices(std::size_t frame);
+    
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
     
 };
@@ -22,23 +22,105 @@
 ////////////////////////////////////////////////////////////
 
 #include "Animation.hpp"
+#include "SpriteAtlas.hpp"
 
-Animation::Animation() : m_texture(NULL)
+#include <algorithm>
+#include <iostream>
+
+Animation::Animation() : m_table(NULL), m_tableSize(0), m_texture(NULL), m_atlas(NULL), m_isLooped(true)
 {
     
 }
 
 
 
-void Animation::addFrame(sf::IntRect rect)
+void Animation::addFrame(sf::IntRect rect, std::size_t hold)
 {
-    pivot += sf::Vector2f(rect.width, rect.height);
+    if (hold == 0)
+        return;
+    
+    // appending to a table copies it first
+    if (m_table)
+    {
+        const FrameRect* table = m_table;
+        m_table = NULL;
+        m_frames.reserve(m_tableSize + 1);
+        m_offsets.reserve(m_tableSize + 1);
+        for (std::size_t i = 0; i < m_tableSize; ++i)
+        {
+            m_frames.push_back(sf::IntRect(table[i].left, table[i].top, table[i].width, table[i].height));
+            m_offsets.push_back(sf::Vector2f());
+        }
+        m_tableSize = 0;
+    }
+    if (m_ends.empty())
+    {
+        m_ends.reserve(m_frames.size() + 1);
+        for (std::size_t i = 0; i < m_frames.size(); ++i)
+            m_ends.push_back(i + 1);
+    }
+    
+    sf::Vector2f offset;
+    if (m_atlas && !m_atlas->findFrame(rect, rect, offset))
+    {
+        std::cout << "fail find atlas frame " << rect.left << "," << rect.top << std::endl;
+        rect = sf::IntRect();
+    }
+    
+    if (!m_frames.empty() && m_frames.back() == rect && m_offsets.back() == offset)
+    {
+        m_ends.back() += hold;
+        return;
+    }
+    
+    std::size_t start = m_ends.empty() ? 0 : m_ends.back();
     m_frames.push_back(rect);
+    m_offsets.push_back(offset);
+    m_ends.push_back(start + hold);
+}
+
+void Animation::setFrames(const FrameRect* frames, std::size_t count, const uint32_t* holds)
+{
+    m_frames.clear();
+    m_offsets.clear();
+    m_ends.clear();
+    m_table = NULL;
+    m_tableSize = 0;
+    
+    if (m_atlas)
+    {
+        m_frames.reserve(count);
+        m_offsets.reserve(count);
+        m_ends.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+            addFrame(sf::IntRect(frames[i].left, frames[i].top, frames[i].width, frames[i].height), holds ? holds[i] : 1);
+        return;
+    }
+    
+    m_table = frames;
+    m_tableSize = count;
+    if (holds)
+    {
+        m_ends.reserve(count);
+        std::size_t end = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            end += holds[i];
+            m_ends.push_back(end);
+        }
+    }
 }
 
 void Animation::setSpriteSheet(const sf::Texture& texture)
 {
     m_texture = &texture;
+    m_atlas = NULL;
+}
+
+void Animation::setSpriteSheet(const SpriteAtlas& atlas)
+{
+    m_texture = &atlas.getTexture();
+    m_atlas = &atlas;
 }
 
 const sf::Texture* Animation::getSpriteSheet() const
@@ -48,16 +130,74 @@ const sf::Texture* Animation::getSpriteSheet() const
 
 std::size_t Animation::getSize() const
 {
-    return m_frames.size();
+    return m_ends.empty() ? getFrameCount() : m_ends.back();
+}
+
+std::size_t Animation::getFrameCount() const
+{
+    return m_table ? m_tableSize : m_frames.size();
+}
+
+std::size_t Animation::getFrameIndex(std::size_t position) const
+{
+    if (m_ends.empty())
+        return position;
+    return std::upper_bound(m_ends.begin(), m_ends.end(), position) - m_ends.begin();
+}
+
+std::size_t Animation::getFrameStart(std::size_t n) const
+{
+    if (m_ends.empty())
+        return n;
+    return n == 0 ? 0 : m_ends[n - 1];
+}
+
+std::size_t Animation::getFrameHold(std::size_t n) const
+{
+    if (m_ends.empty())
+        return 1;
+    return m_ends[n] - getFrameStart(n);
 }
 
 sf::Vector2f Animation::getPivot() const
 {
-    return pivot;
+    return m_pivot;
+}
+
+void Animation::setPivot(sf::Vector2f value)
+{
+    m_pivot = value;
 }
 
+void Animation::setFrameTime(sf::Time time)
+{
+    m_frameTime = time;
+}
+
+sf::Time Animation::getFrameTime() const
+{
+    return m_frameTime;
+}
 
-const sf::IntRect& Animation::getFrame(std::size_t n) const
+void Animation::setLooped(bool looped)
 {
+    m_isLooped = looped;
+}
+
+bool Animation::isLooped() const
+{
+    return m_isLooped;
+}
+
+
+sf::IntRect Animation::getFrame(std::size_t n) const
+{
+    if (m_table)
+        return sf::IntRect(m_table[n].left, m_table[n].top, m_table[n].width, m_table[n].height);
     return m_frames[n];
+}
+
+sf::Vector2f Animation::getFrameOffset(std::size_t n) const
+{
+    return m_table ? sf::Vector2f() : m_offsets[n];
 }
\ No newline at end of file
@@ -24,8 +24,16 @@
 #ifndef ANIMATION_INCLUDE
 #define ANIMATION_INCLUDE
 
+#include <vector>
+#include <stdint.h>
+
 #include <SFML/Graphics/Rect.hpp>
 #include <SFML/Graphics/Texture.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "FrameTable.hpp"
+
+class SpriteAtlas;
 
 class Animation
 {
@@ -33,16 +41,51 @@ public:
     Animation();
     
     sf::Vector2f getPivot() const;
-    void addFrame(sf::IntRect rect);
+    void setPivot(sf::Vector2f value);
+    // playback defaults for sprites, Zero leaves the sprite frame time alone
+    void setFrameTime(sf::Time time);
+    sf::Time getFrameTime() const;
+    void setLooped(bool looped);
+    bool isLooped() const;
+    // hold is the number of frame times the frame stays on screen; a frame
+    // equal to the previous one extends its hold
+    void addFrame(sf::IntRect rect, std::size_t hold = 1);
+    // uses the frames in place, they must outlive the animation; with an
+    // atlas sheet they are looked up and copied like addFrame. holds may be
+    // NULL for one frame time each
+    void setFrames(const FrameRect* frames, std::size_t count, const uint32_t* holds = NULL);
+    template <std::size_t N>
+    void setFrames(const FrameTable<N>& table)
+    {
+        setFrames(table.frames, N);
+    }
     void setSpriteSheet(const sf::Texture& texture);
+    // frames added afterwards are given in sheet coordinates and looked up in the atlas
+    void setSpriteSheet(const SpriteAtlas& atlas);
     const sf::Texture* getSpriteSheet() const;
+    // length in frame times, counting every hold
     std::size_t getSize() const;
-    const sf::IntRect& getFrame(std::size_t n) const;
+    // distinct frames
+    std::size_t getFrameCount() const;
+    // frame shown at a position in frame times
+    std::size_t getFrameIndex(std::size_t position) const;
+    std::size_t getFrameStart(std::size_t n) const;
+    std::size_t getFrameHold(std::size_t n) const;
+    sf::IntRect getFrame(std::size_t n) const;
+    sf::Vector2f getFrameOffset(std::size_t n) const;
     
 private:
-    sf::Vector2f pivot;
+    sf::Vector2f m_pivot;
+    const FrameRect* m_table;
+    std::size_t m_tableSize;
     std::vector<sf::IntRect> m_frames;
+    std::vector<sf::Vector2f> m_offsets;
+    // end position of every frame, empty when each is held once
+    std::vector<std::size_t> m_ends;
     const sf::Texture* m_texture;
+    const SpriteAtlas* m_atlas;
+    sf::Time m_frameTime;
+    bool m_isLooped;
 };
 
 #endif // ANIMATION_INCLUDE
\ No newline at end of file
@@ -0,0 +1,494 @@
+//============================================================================
+// Name        : AnimationLibrary.cpp
+// Description : animations defined in xml, with a compiled binary cache
+//============================================================================
+
+#include "AnimationLibrary.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "AssetPack.hpp"
+#include "tinyxml.h"
+
+namespace
+{
+    // File layout, native endian since the cache never leaves the machine:
+    //   header     : char magic[8] = "FCANC03", uint64 xmlHash, uint64 xmlSize,
+    //                uint32 sheetCount, uint32 animationCount, uint32 frameCount,
+    //                uint32 reserved
+    //   sheets     : string texture, string atlas
+    //   animations : string name, string group, uint32 sheet, float frameTime,
+    //                uint32 looped, float pivotX, float pivotY, uint32 firstFrame,
+    //                uint32 frameCount
+    //   frames     : int32 left, top, width, height
+    //   holds      : uint32 per frame
+    // strings are a uint32 length followed by the bytes
+    const char CacheMagic[8] = "FCANC03";
+
+    // FNV-1a over the xml bytes, as the packer hashes frames: any edit changes
+    // it, whatever the time or size of the file
+    uint64_t hashBytes(const unsigned char* bytes, std::size_t size)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    class CacheReader
+    {
+    public:
+        CacheReader(const std::vector<char>& data) : m_data(data), m_offset(0)
+        {
+
+        }
+
+        template <typename T>
+        bool read(T& value)
+        {
+            if (m_data.size() - m_offset < sizeof(T))
+                return false;
+            std::memcpy(&value, &m_data[m_offset], sizeof(T));
+            m_offset += sizeof(T);
+            return true;
+        }
+
+        bool read(std::string& value)
+        {
+            uint32_t length = 0;
+            if (!read(length) || m_data.size() - m_offset < length)
+                return false;
+            value.assign(m_data.begin() + m_offset, m_data.begin() + m_offset + length);
+            m_offset += length;
+            return true;
+        }
+
+        bool isAtEnd() const
+        {
+            return m_offset == m_data.size();
+        }
+
+    private:
+        const std::vector<char>& m_data;
+        std::size_t m_offset;
+    };
+
+    class CacheWriter
+    {
+    public:
+        template <typename T>
+        void write(const T& value)
+        {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+        }
+
+        void write(const std::string& value)
+        {
+            write(static_cast<uint32_t>(value.size()));
+            m_data.insert(m_data.end(), value.begin(), value.end());
+        }
+
+        const std::vector<char>& getData() const
+        {
+            return m_data;
+        }
+
+    private:
+        std::vector<char> m_data;
+    };
+
+    std::shared_future<bool> makeFuture(bool value)
+    {
+        std::promise<bool> promise;
+        promise.set_value(value);
+        return promise.get_future().share();
+    }
+
+    const char* getAttribute(const TiXmlElement* element, const char* name, const char* fallback)
+    {
+        const char* value = element->Attribute(name);
+        return value ? value : fallback;
+    }
+}
+
+AnimationLibrary::AnimationLibrary() : m_isFromCache(false)
+{
+
+}
+
+bool AnimationLibrary::loadFromFile(const std::string& path, const std::string& cachePath, AssetLoader* loader)
+{
+    // the cache is stamped with the xml's bytes, from the pack or the disk;
+    // reading them is cheap next to parsing
+    std::size_t packedSize = 0;
+    const unsigned char* packed = resourcePack().find(path, packedSize);
+    std::vector<unsigned char> text;
+    if (!packed)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            std::cout << "fail open " << path << std::endl;
+            return false;
+        }
+        unsigned char buffer[4096];
+        std::size_t count;
+        while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            text.insert(text.end(), buffer, buffer + count);
+        std::fclose(file);
+    }
+    uint64_t size = packed ? packedSize : text.size();
+    uint64_t stamp = packed ? hashBytes(packed, packedSize) : hashBytes(text.empty() ? NULL : &text[0], text.size());
+
+    m_isFromCache = !cachePath.empty() && readCache(cachePath, stamp, size);
+    if (!m_isFromCache)
+    {
+        if (!parseXml(path))
+            return false;
+        if (!cachePath.empty() && !writeCache(cachePath, stamp, size))
+            std::cout << "fail write animation cache " << cachePath << std::endl;
+    }
+
+    std::string::size_type slash = path.find_last_of('/');
+    return build(slash == std::string::npos ? std::string() : path.substr(0, slash + 1), loader);
+}
+
+const Animation* AnimationLibrary::findAnimation(const std::string& name) const
+{
+    std::map<std::string, std::size_t>::const_iterator it = m_names.find(name);
+    return it == m_names.end() ? NULL : &m_animations[it->second];
+}
+
+std::shared_future<bool> AnimationLibrary::getFuture(const std::string& name) const
+{
+    std::map<std::string, std::size_t>::const_iterator it = m_names.find(name);
+    if (it == m_names.end())
+        return makeFuture(false);
+    return m_futures[m_animationDefs[it->second].sheet];
+}
+
+bool AnimationLibrary::isLoaded() const
+{
+    for (std::size_t i = 0; i < m_futures.size(); ++i)
+    {
+        if (m_futures[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready || !m_futures[i].get())
+            return false;
+    }
+    return true;
+}
+
+std::vector<Animation> AnimationLibrary::getGroup(const std::string& group) const
+{
+    std::vector<Animation> animations;
+    for (std::size_t i = 0; i < m_animationDefs.size(); ++i)
+    {
+        if (m_animationDefs[i].group == group)
+            animations.push_back(m_animations[i]);
+    }
+    return animations;
+}
+
+std::size_t AnimationLibrary::getAnimationCount() const
+{
+    return m_animations.size();
+}
+
+bool AnimationLibrary::isFromCache() const
+{
+    return m_isFromCache;
+}
+
+bool AnimationLibrary::parseXml(const std::string& path)
+{
+    m_sheetDefs.clear();
+    m_animationDefs.clear();
+    m_frameDefs.clear();
+    m_holdDefs.clear();
+
+    TiXmlDocument document(path.c_str());
+    std::size_t size = 0;
+    const unsigned char* packed = resourcePack().find(path, size);
+    if (packed)
+    {
+        // Parse wants a terminated string, the mapping is not
+        std::string text(reinterpret_cast<const char*>(packed), size);
+        document.Parse(text.c_str());
+    }
+    if (packed ? document.Error() : !document.LoadFile())
+    {
+        std::cout << "fail parse " << path << ": " << document.ErrorDesc() << " line " << document.ErrorRow() << std::endl;
+        return false;
+    }
+
+    const TiXmlElement* root = document.FirstChildElement("animations");
+    if (!root)
+    {
+        std::cout << "fail parse " << path << ": no animations element" << std::endl;
+        return false;
+    }
+
+    for (const TiXmlElement* sheet = root->FirstChildElement("sheet"); sheet; sheet = sheet->NextSiblingElement("sheet"))
+    {
+        SheetDef sheetDef;
+        sheetDef.texture = getAttribute(sheet, "texture", "");
+        sheetDef.atlas = getAttribute(sheet, "atlas", "");
+        if (sheetDef.texture.empty())
+        {
+            std::cout << "fail parse " << path << ": sheet without texture, line " << sheet->Row() << std::endl;
+            return false;
+        }
+        m_sheetDefs.push_back(sheetDef);
+
+        for (const TiXmlElement* animation = sheet->FirstChildElement("animation"); animation; animation = animation->NextSiblingElement("animation"))
+        {
+            AnimationDef animationDef;
+            animationDef.name = getAttribute(animation, "name", "");
+            animationDef.group = getAttribute(animation, "group", "");
+            animationDef.sheet = static_cast<uint32_t>(m_sheetDefs.size() - 1);
+            animationDef.looped = std::string(getAttribute(animation, "loop", "true")) != "false";
+            animationDef.frameTime = 0.f;
+            animationDef.pivotX = 0.f;
+            animationDef.pivotY = 0.f;
+            animation->QueryFloatAttribute("frameTime", &animationDef.frameTime);
+            animation->QueryFloatAttribute("pivotX", &animationDef.pivotX);
+            animation->QueryFloatAttribute("pivotY", &animationDef.pivotY);
+            animationDef.firstFrame = static_cast<uint32_t>(m_frameDefs.size());
+            if (animationDef.name.empty())
+            {
+                std::cout << "fail parse " << path << ": animation without name, line " << animation->Row() << std::endl;
+                return false;
+            }
+
+            for (const TiXmlElement* frame = animation->FirstChildElement("frame"); frame; frame = frame->NextSiblingElement("frame"))
+            {
+                FrameRect frameDef;
+                int count = 1;
+                if (frame->QueryIntAttribute("x", &frameDef.left) != TIXML_SUCCESS
+                    || frame->QueryIntAttribute("y", &frameDef.top) != TIXML_SUCCESS
+                    || frame->QueryIntAttribute("w", &frameDef.width) != TIXML_SUCCESS
+                    || frame->QueryIntAttribute("h", &frameDef.height) != TIXML_SUCCESS
+                    || frame->QueryIntAttribute("count", &count) == TIXML_WRONG_TYPE
+                    || count < 1)
+                {
+                    std::cout << "fail parse " << path << ": bad frame, line " << frame->Row() << std::endl;
+                    return false;
+                }
+                // repeated frames become a longer hold
+                if (m_frameDefs.size() > animationDef.firstFrame && std::memcmp(&m_frameDefs.back(), &frameDef, sizeof(frameDef)) == 0)
+                {
+                    m_holdDefs.back() += count;
+                    continue;
+                }
+                m_frameDefs.push_back(frameDef);
+                m_holdDefs.push_back(count);
+            }
+
+            animationDef.frameCount = static_cast<uint32_t>(m_frameDefs.size()) - animationDef.firstFrame;
+            m_animationDefs.push_back(animationDef);
+        }
+    }
+
+    return true;
+}
+
+bool AnimationLibrary::readCache(const std::string& cachePath, uint64_t stamp, uint64_t size)
+{
+    std::FILE* file = std::fopen(cachePath.c_str(), "rb");
+    if (!file)
+        return false;
+
+    std::vector<char> data;
+    bool valid = std::fseek(file, 0, SEEK_END) == 0;
+    long length = valid ? std::ftell(file) : -1;
+    if (length > 0 && std::fseek(file, 0, SEEK_SET) == 0)
+    {
+        data.resize(length);
+        valid = std::fread(&data[0], 1, data.size(), file) == data.size();
+    }
+    std::fclose(file);
+    if (!valid || data.empty())
+        return false;
+
+    CacheReader reader(data);
+    char magic[8];
+    uint64_t cachedStamp = 0, cachedSize = 0;
+    uint32_t sheetCount = 0, animationCount = 0, frameCount = 0, reserved = 0;
+    if (!reader.read(magic) || std::memcmp(magic, CacheMagic, sizeof(magic)) != 0
+        || !reader.read(cachedStamp) || !reader.read(cachedSize)
+        || cachedStamp != stamp || cachedSize != size
+        || !reader.read(sheetCount) || !reader.read(animationCount)
+        || !reader.read(frameCount) || !reader.read(reserved))
+        return false;
+
+    std::vector<SheetDef> sheetDefs(sheetCount);
+    for (std::size_t i = 0; i < sheetDefs.size(); ++i)
+    {
+        if (!reader.read(sheetDefs[i].texture) || !reader.read(sheetDefs[i].atlas))
+            return false;
+    }
+
+    std::vector<AnimationDef> animationDefs(animationCount);
+    for (std::size_t i = 0; i < animationDefs.size(); ++i)
+    {
+        AnimationDef& def = animationDefs[i];
+        if (!reader.read(def.name) || !reader.read(def.group) || !reader.read(def.sheet)
+            || !reader.read(def.frameTime) || !reader.read(def.looped)
+            || !reader.read(def.pivotX) || !reader.read(def.pivotY)
+            || !reader.read(def.firstFrame) || !reader.read(def.frameCount)
+            || def.sheet >= sheetCount || def.firstFrame > frameCount
+            || def.frameCount > frameCount - def.firstFrame)
+            return false;
+    }
+
+    std::vector<FrameRect> frameDefs(frameCount);
+    for (std::size_t i = 0; i < frameDefs.size(); ++i)
+    {
+        if (!reader.read(frameDefs[i]))
+            return false;
+    }
+
+    std::vector<uint32_t> holdDefs(frameCount);
+    for (std::size_t i = 0; i < holdDefs.size(); ++i)
+    {
+        if (!reader.read(holdDefs[i]))
+            return false;
+    }
+    if (!reader.isAtEnd())
+        return false;
+
+    m_sheetDefs.swap(sheetDefs);
+    m_animationDefs.swap(animationDefs);
+    m_frameDefs.swap(frameDefs);
+    m_holdDefs.swap(holdDefs);
+    return true;
+}
+
+bool AnimationLibrary::writeCache(const std::string& cachePath, uint64_t stamp, uint64_t size) const
+{
+    CacheWriter writer;
+    writer.write(CacheMagic);
+    writer.write(stamp);
+    writer.write(size);
+    writer.write(static_cast<uint32_t>(m_sheetDefs.size()));
+    writer.write(static_cast<uint32_t>(m_animationDefs.size()));
+    writer.write(static_cast<uint32_t>(m_frameDefs.size()));
+    writer.write(static_cast<uint32_t>(0));
+
+    for (std::size_t i = 0; i < m_sheetDefs.size(); ++i)
+    {
+        writer.write(m_sheetDefs[i].texture);
+        writer.write(m_sheetDefs[i].atlas);
+    }
+
+    for (std::size_t i = 0; i < m_animationDefs.size(); ++i)
+    {
+        const AnimationDef& def = m_animationDefs[i];
+        writer.write(def.name);
+        writer.write(def.group);
+        writer.write(def.sheet);
+        writer.write(def.frameTime);
+        writer.write(def.looped);
+        writer.write(def.pivotX);
+        writer.write(def.pivotY);
+        writer.write(def.firstFrame);
+        writer.write(def.frameCount);
+    }
+
+    for (std::size_t i = 0; i < m_frameDefs.size(); ++i)
+        writer.write(m_frameDefs[i]);
+
+    for (std::size_t i = 0; i < m_holdDefs.size(); ++i)
+        writer.write(m_holdDefs[i]);
+
+    // written aside and renamed so a crash never leaves a torn cache
+    std::string temporary = cachePath + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file)
+        return false;
+    const std::vector<char>& data = writer.getData();
+    bool written = std::fwrite(&data[0], 1, data.size(), file) == data.size();
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(temporary.c_str(), cachePath.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool AnimationLibrary::build(const std::string& directory, AssetLoader* loader)
+{
+    m_textures.clear();
+    m_atlases.clear();
+    m_futures.clear();
+    m_animations.clear();
+    m_names.clear();
+
+    for (std::size_t i = 0; i < m_sheetDefs.size(); ++i)
+    {
+        const SheetDef& def = m_sheetDefs[i];
+        m_textures.push_back(std::unique_ptr<sf::Texture>());
+        m_atlases.push_back(std::unique_ptr<SpriteAtlas>());
+
+        if (!def.atlas.empty())
+        {
+            std::unique_ptr<SpriteAtlas> atlas(new SpriteAtlas);
+            if (loader && atlas->loadMetadataFromFile(directory + def.atlas))
+            {
+                m_futures.push_back(loader->load(atlas->getTexture(), atlas->getTexturePath()));
+                m_atlases.back().swap(atlas);
+                continue;
+            }
+            if (!loader && atlas->loadFromFile(directory + def.atlas))
+            {
+                m_futures.push_back(makeFuture(true));
+                m_atlases.back().swap(atlas);
+                continue;
+            }
+        }
+
+        std::unique_ptr<sf::Texture> texture(new sf::Texture);
+        if (loader)
+        {
+            m_futures.push_back(loader->load(*texture, directory + def.texture));
+        }
+        else if (loadResource(*texture, directory + def.texture))
+        {
+            m_futures.push_back(makeFuture(true));
+        }
+        else
+        {
+            std::cout << "fail load texture " << def.texture << std::endl;
+            return false;
+        }
+        m_textures.back().swap(texture);
+    }
+
+    m_animations.resize(m_animationDefs.size());
+    for (std::size_t i = 0; i < m_animationDefs.size(); ++i)
+    {
+        const AnimationDef& def = m_animationDefs[i];
+        Animation& animation = m_animations[i];
+        if (m_atlases[def.sheet])
+            animation.setSpriteSheet(*m_atlases[def.sheet]);
+        else
+            animation.setSpriteSheet(*m_textures[def.sheet]);
+
+        if (def.frameCount > 0)
+            animation.setFrames(&m_frameDefs[def.firstFrame], def.frameCount, &m_holdDefs[def.firstFrame]);
+        animation.setFrameTime(sf::seconds(def.frameTime));
+        animation.setLooped(def.looped != 0);
+        animation.setPivot(sf::Vector2f(def.pivotX, def.pivotY));
+
+        if (!m_names.insert(std::make_pair(def.name, i)).second)
+            std::cout << "duplicate animation " << def.name << std::endl;
+    }
+
+    return true;
+}
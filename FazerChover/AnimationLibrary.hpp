@@ -0,0 +1,103 @@
+//============================================================================
+// Name        : AnimationLibrary.hpp
+// Description : animations defined in xml, with a compiled binary cache
+//============================================================================
+
+#ifndef ANIMATIONLIBRARY_INCLUDE
+#define ANIMATIONLIBRARY_INCLUDE
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <SFML/Graphics/Texture.hpp>
+
+#include "Animation.hpp"
+#include "AssetLoader.hpp"
+#include "SpriteAtlas.hpp"
+
+// <animations>
+//     <sheet texture="cenario.png" atlas="cenario_atlas.atlas">
+//         <animation name="cenario" group="" frameTime="0.2" loop="false" pivotX="0" pivotY="0">
+//             <frame x="0" y="0" w="222" h="170" count="3"/>
+//
+// The atlas is optional and used when present next to the texture. The parsed
+// definitions are stored in a cache file stamped with the size and a hash of
+// the xml; while they match, loading is a single read of the cache. The xml,
+// atlases and textures are taken from the resource pack when it holds them.
+class AnimationLibrary
+{
+public:
+    AnimationLibrary();
+
+    // textures are loaded from the directory of path, right away or, with a
+    // loader, in the background; animations can be used before their sheet
+    // is ready but draw nothing useful until then
+    bool loadFromFile(const std::string& path, const std::string& cachePath, AssetLoader* loader = NULL);
+
+    // ready once the sheet of the animation is loaded, true on success
+    std::shared_future<bool> getFuture(const std::string& name) const;
+
+    // every sheet loaded successfully
+    bool isLoaded() const;
+
+    // NULL when the file defines no such animation; animations, and copies
+    // of them, are valid until the next load
+    const Animation* findAnimation(const std::string& name) const;
+
+    // animations of a group in file order
+    std::vector<Animation> getGroup(const std::string& group) const;
+
+    std::size_t getAnimationCount() const;
+
+    // true when the last load was served from the cache
+    bool isFromCache() const;
+
+private:
+    AnimationLibrary(const AnimationLibrary&);
+    AnimationLibrary& operator=(const AnimationLibrary&);
+
+    struct SheetDef
+    {
+        std::string texture;
+        std::string atlas;
+    };
+
+    struct AnimationDef
+    {
+        std::string name;
+        std::string group;
+        uint32_t sheet;
+        float frameTime;
+        uint32_t looped;
+        float pivotX;
+        float pivotY;
+        uint32_t firstFrame;
+        uint32_t frameCount;
+    };
+
+    bool parseXml(const std::string& path);
+    bool readCache(const std::string& cachePath, uint64_t stamp, uint64_t size);
+    bool writeCache(const std::string& cachePath, uint64_t stamp, uint64_t size) const;
+    bool build(const std::string& directory, AssetLoader* loader);
+
+    std::vector<SheetDef> m_sheetDefs;
+    std::vector<AnimationDef> m_animationDefs;
+    // frames of every animation back to back, animations on a plain
+    // texture use them in place
+    std::vector<FrameRect> m_frameDefs;
+    std::vector<uint32_t> m_holdDefs;
+
+    // animations keep pointers to these
+    std::vector<std::unique_ptr<sf::Texture> > m_textures;
+    std::vector<std::unique_ptr<SpriteAtlas> > m_atlases;
+    std::vector<std::shared_future<bool> > m_futures;
+    std::vector<Animation> m_animations;
+    std::map<std::string, std::size_t> m_names;
+    bool m_isFromCache;
+};
+
+#endif // ANIMATIONLIBRARY_INCLUDE
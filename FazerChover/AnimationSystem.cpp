@@ -0,0 +1,229 @@
+//============================================================================
+// Name        : AnimationSystem.cpp
+// Description : thousands of small animated sprites in one vertex buffer
+//============================================================================
+
+#include "AnimationSystem.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // time inside the animation after it ran to t: wrapped when looped,
+    // held at either end when not. Only arithmetic, min and max, which keeps
+    // the update loop vectorizable: truncating twice wraps negative times
+    // without floor or a compare, loop (0 or 1) blends instead of selecting
+    inline float wrapTime(float t, float duration, float loop)
+    {
+        float wrapped = t - static_cast<float>(static_cast<int32_t>(t / duration)) * duration + duration;
+        wrapped -= static_cast<float>(static_cast<int32_t>(wrapped / duration)) * duration;
+        float clamped = std::min(std::max(t, 0.f), duration);
+        return clamped + loop * (wrapped - clamped);
+    }
+
+    // position at time, relative to the first one. Forward a frame time
+    // starts on its boundary, in reverse it ends there, as AnimatedSprite
+    // plays it. Rounding leaves time a step below 0 or on duration, so the
+    // position is wrapped or held again in integers and never leaves
+    // [0, last]. Compares only turn into 0 or 1, as in wrapTime
+    inline int32_t positionAt(float time, float rate, int32_t last, float loop, float speed)
+    {
+        float steps = time * rate;
+        int32_t position = static_cast<int32_t>(steps);
+        position -= static_cast<float>(position) > steps;
+        position -= (speed < 0.f) & (static_cast<float>(position) == steps);
+        int32_t wrapped = position + (last + 1) * ((position < 0) - (position > last));
+        int32_t held = std::min(std::max(position, 0), last);
+        return held + static_cast<int32_t>(loop) * (wrapped - held);
+    }
+}
+
+AnimationSystem::AnimationSystem() : m_texture(NULL)
+{
+
+}
+
+int AnimationSystem::addAnimation(const Animation& animation, sf::Time frameTime)
+{
+    const sf::Texture* texture = animation.getSpriteSheet();
+    if (!texture || (m_texture && texture != m_texture) || animation.getFrameCount() == 0)
+        return -1;
+    m_texture = texture;
+
+    if (frameTime <= sf::Time::Zero)
+        frameTime = animation.getFrameTime();
+    if (frameTime <= sf::Time::Zero)
+        frameTime = sf::seconds(0.2f);
+
+    AnimationInfo info;
+    info.firstPosition = m_positionQuads.size();
+    info.length = animation.getSize();
+    info.frameTime = frameTime.asSeconds();
+    info.isLooped = animation.isLooped();
+
+    std::size_t firstQuad = m_quads.size();
+    std::size_t frameCount = animation.getFrameCount();
+    for (std::size_t n = 0; n < frameCount; n++) {
+        // the same corners as AnimatedSprite::setVertices
+        sf::IntRect rect = animation.getFrame(n);
+        sf::Vector2f offset = animation.getFrameOffset(n);
+        Quad quad;
+        quad.left = offset.x;
+        quad.top = offset.y;
+        quad.right = offset.x + static_cast<float>(rect.width);
+        quad.bottom = offset.y + static_cast<float>(rect.height);
+        quad.textureLeft = static_cast<float>(rect.left) + 0.0001f;
+        quad.textureTop = static_cast<float>(rect.top);
+        quad.textureRight = quad.textureLeft + static_cast<float>(rect.width);
+        quad.textureBottom = quad.textureTop + static_cast<float>(rect.height);
+        m_quads.push_back(quad);
+    }
+    for (std::size_t position = 0; position < info.length; position++)
+        m_positionQuads.push_back(static_cast<uint32_t>(firstQuad + std::min(animation.getFrameIndex(position), frameCount - 1)));
+
+    m_animations.push_back(info);
+    return static_cast<int>(m_animations.size() - 1);
+}
+
+std::size_t AnimationSystem::add(int animation, sf::Vector2f position, sf::Time offset)
+{
+    if (animation < 0 || static_cast<std::size_t>(animation) >= m_animations.size())
+        return NoInstance;
+
+    const AnimationInfo& info = m_animations[animation];
+    float duration = info.frameTime * info.length;
+    float loop = info.isLooped ? 1.f : 0.f;
+    float time = wrapTime(offset.asSeconds(), duration, loop);
+    int32_t last = static_cast<int32_t>(info.length) - 1;
+
+    m_time.push_back(time);
+    m_speed.push_back(1.f);
+    m_duration.push_back(duration);
+    m_rate.push_back(1.f / info.frameTime);
+    m_loop.push_back(loop);
+    m_firstPosition.push_back(static_cast<int32_t>(info.firstPosition));
+    m_lastPosition.push_back(last);
+    m_position.push_back(static_cast<int32_t>(info.firstPosition) + positionAt(time, m_rate.back(), last, loop, 1.f));
+    m_x.push_back(position.x);
+    m_y.push_back(position.y);
+    m_velocityX.push_back(0.f);
+    m_velocityY.push_back(0.f);
+    m_vertices.resize(m_vertices.size() + 4, sf::Vertex(sf::Vector2f(), sf::Color::White, sf::Vector2f()));
+    return m_time.size() - 1;
+}
+
+void AnimationSystem::setPosition(std::size_t instance, sf::Vector2f position)
+{
+    m_x[instance] = position.x;
+    m_y[instance] = position.y;
+}
+
+void AnimationSystem::setVelocity(std::size_t instance, sf::Vector2f velocity)
+{
+    m_velocityX[instance] = velocity.x;
+    m_velocityY[instance] = velocity.y;
+}
+
+void AnimationSystem::setSpeed(std::size_t instance, float speed)
+{
+    m_speed[instance] = speed;
+}
+
+void AnimationSystem::setLooped(std::size_t instance, bool looped)
+{
+    m_loop[instance] = looped ? 1.f : 0.f;
+}
+
+void AnimationSystem::clear()
+{
+    m_time.clear();
+    m_speed.clear();
+    m_duration.clear();
+    m_rate.clear();
+    m_loop.clear();
+    m_firstPosition.clear();
+    m_lastPosition.clear();
+    m_position.clear();
+    m_x.clear();
+    m_y.clear();
+    m_velocityX.clear();
+    m_velocityY.clear();
+    m_vertices.clear();
+}
+
+void AnimationSystem::update(sf::Time deltaTime)
+{
+    std::size_t count = m_time.size();
+    if (count == 0)
+        return;
+    float seconds = deltaTime.asSeconds();
+
+    // clocks, animation positions and instance positions, each loop over a
+    // few plain arrays so the compiler can check they do not overlap and
+    // vectorize it
+    float* time = &m_time[0];
+    const float* speed = &m_speed[0];
+    const float* duration = &m_duration[0];
+    const float* loop = &m_loop[0];
+    for (std::size_t i = 0; i < count; i++)
+        time[i] = wrapTime(time[i] + seconds * speed[i], duration[i], loop[i]);
+
+    const float* rate = &m_rate[0];
+    const int32_t* firstPosition = &m_firstPosition[0];
+    const int32_t* lastPosition = &m_lastPosition[0];
+    int32_t* position = &m_position[0];
+    for (std::size_t i = 0; i < count; i++)
+        position[i] = firstPosition[i] + positionAt(time[i], rate[i], lastPosition[i], loop[i], speed[i]);
+
+    float* x = &m_x[0];
+    float* y = &m_y[0];
+    const float* velocityX = &m_velocityX[0];
+    const float* velocityY = &m_velocityY[0];
+    for (std::size_t i = 0; i < count; i++) {
+        x[i] += seconds * velocityX[i];
+        y[i] += seconds * velocityY[i];
+    }
+
+    // quads, straight into the vertex buffer
+    const Quad* quads = &m_quads[0];
+    const uint32_t* positionQuads = &m_positionQuads[0];
+    sf::Vertex* vertices = &m_vertices[0];
+    for (std::size_t i = 0; i < count; i++, vertices += 4) {
+        const Quad& quad = quads[positionQuads[position[i]]];
+        float left = x[i] + quad.left;
+        float top = y[i] + quad.top;
+        float right = x[i] + quad.right;
+        float bottom = y[i] + quad.bottom;
+        vertices[0].position = sf::Vector2f(left, top);
+        vertices[1].position = sf::Vector2f(left, bottom);
+        vertices[2].position = sf::Vector2f(right, bottom);
+        vertices[3].position = sf::Vector2f(right, top);
+        vertices[0].texCoords = sf::Vector2f(quad.textureLeft, quad.textureTop);
+        vertices[1].texCoords = sf::Vector2f(quad.textureLeft, quad.textureBottom);
+        vertices[2].texCoords = sf::Vector2f(quad.textureRight, quad.textureBottom);
+        vertices[3].texCoords = sf::Vector2f(quad.textureRight, quad.textureTop);
+    }
+}
+
+std::size_t AnimationSystem::getSize() const
+{
+    return m_time.size();
+}
+
+sf::Vector2f AnimationSystem::getPosition(std::size_t instance) const
+{
+    return sf::Vector2f(m_x[instance], m_y[instance]);
+}
+
+std::size_t AnimationSystem::getCurrentFrame(std::size_t instance) const
+{
+    return static_cast<std::size_t>(m_position[instance] - m_firstPosition[instance]);
+}
+
+void AnimationSystem::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    if (!m_texture || m_vertices.empty())
+        return;
+    states.texture = m_texture;
+    target.draw(&m_vertices[0], m_vertices.size(), sf::Quads, states);
+}
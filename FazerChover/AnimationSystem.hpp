@@ -0,0 +1,108 @@
+//============================================================================
+// Name        : AnimationSystem.hpp
+// Description : thousands of small animated sprites in one vertex buffer
+//============================================================================
+
+#ifndef ANIMATIONSYSTEM_INCLUDE
+#define ANIMATIONSYSTEM_INCLUDE
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "Animation.hpp"
+
+// For particle like layers (rain) where an AnimatedSprite per instance is too
+// heavy. Instances are not objects: their clock, speed, animation constants,
+// position and velocity live in parallel arrays indexed by instance. update
+// runs branch free loops over those arrays that the compiler vectorizes, then
+// writes every quad into one vertex buffer drawn with a single call.
+//
+// Instances have a position and a velocity only, no scale or rotation. All
+// animations must share one sprite sheet.
+class AnimationSystem : public sf::Drawable
+{
+public:
+    // what add returns for an animation that was not added
+    static const std::size_t NoInstance = static_cast<std::size_t>(-1);
+
+    AnimationSystem();
+
+    // frames are copied, the animation need not outlive the system, but its
+    // sheet does. Zero frameTime takes the animation's. -1 when the sheet
+    // differs from the one of the animations already added
+    int addAnimation(const Animation& animation, sf::Time frameTime = sf::Time::Zero);
+
+    // new instance, playing forward from offset into the animation, looped
+    // like the animation. NoInstance when animation is not one addAnimation
+    // returned, -1 included
+    std::size_t add(int animation, sf::Vector2f position, sf::Time offset = sf::Time::Zero);
+    void setPosition(std::size_t instance, sf::Vector2f position);
+    // pixels per second, applied by update
+    void setVelocity(std::size_t instance, sf::Vector2f velocity);
+    // playback rate: 1 normal, 0 paused, negative plays in reverse the way
+    // AnimatedSprite does. The clock runs backwards, so a reversed instance
+    // that does not loop starts from an offset of the animation's duration
+    void setSpeed(std::size_t instance, float speed);
+    void setLooped(std::size_t instance, bool looped);
+    // drops every instance, animations are kept
+    void clear();
+
+    // advances every instance and rewrites the vertex buffer, which is
+    // what draw shows
+    void update(sf::Time deltaTime);
+
+    std::size_t getSize() const;
+    sf::Vector2f getPosition(std::size_t instance) const;
+    // position in frame times, counting holds, as AnimatedSprite
+    std::size_t getCurrentFrame(std::size_t instance) const;
+
+private:
+    // a distinct frame, in sheet coordinates and relative to the instance
+    struct Quad
+    {
+        float left, top, right, bottom;
+        float textureLeft, textureTop, textureRight, textureBottom;
+    };
+
+    struct AnimationInfo
+    {
+        std::size_t firstPosition; // into m_positionQuads
+        std::size_t length;        // in frame times
+        float frameTime;           // seconds
+        bool isLooped;
+    };
+
+    virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+
+    const sf::Texture* m_texture;
+    std::vector<AnimationInfo> m_animations;
+    std::vector<Quad> m_quads;
+    // quad of every position of every animation, holds repeat it
+    std::vector<uint32_t> m_positionQuads;
+
+    // per instance, one array each
+    std::vector<float> m_time;          // seconds since the animation start
+    std::vector<float> m_speed;
+    std::vector<float> m_duration;      // of the instance's animation
+    std::vector<float> m_rate;          // frame times per second
+    std::vector<float> m_loop;          // 1 looped, 0 not
+    std::vector<int32_t> m_firstPosition;
+    std::vector<int32_t> m_lastPosition; // relative to m_firstPosition
+    std::vector<int32_t> m_position;    // absolute, into m_positionQuads
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_velocityX;
+    std::vector<float> m_velocityY;
+
+    std::vector<sf::Vertex> m_vertices;
+};
+
+#endif // ANIMATIONSYSTEM_INCLUDE
@@ -0,0 +1,178 @@
+//============================================================================
+// Name        : AssetLoader.cpp
+// Description : decodes textures on worker threads, uploads them in slices
+//============================================================================
+
+#include "AssetLoader.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include <SFML/System/Clock.hpp>
+
+#include "AssetPack.hpp"
+#include "Trace.hpp"
+
+const unsigned AssetLoader::UploadRows;
+
+AssetLoader::AssetLoader(std::size_t threads) : m_isRunning(true), m_isUploading(true)
+{
+    if (threads == 0)
+    {
+        unsigned cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+
+    for (std::size_t i = 0; i < threads; ++i)
+        m_threads.push_back(std::thread(&AssetLoader::run, this));
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isRunning = false;
+    }
+    m_wake.notify_all();
+    for (std::size_t i = 0; i < m_threads.size(); ++i)
+        m_threads[i].join();
+
+    // nobody waits forever on a texture that will never come
+    for (std::list<std::unique_ptr<Job> >::iterator it = m_jobs.begin(); it != m_jobs.end(); ++it)
+        (*it)->promise.set_value(false);
+}
+
+std::shared_future<bool> AssetLoader::load(sf::Texture& texture, const std::string& path)
+{
+    std::unique_ptr<Job> job(new Job);
+    job->texture = &texture;
+    job->path = path;
+    job->uploadedRows = 0;
+    job->isCreated = false;
+    job->isFailed = false;
+    std::shared_future<bool> future = job->promise.get_future().share();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_decodeQueue.push_back(job.get());
+        m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+    return future;
+}
+
+void AssetLoader::setUploading(bool uploading)
+{
+    m_isUploading = uploading;
+}
+
+bool AssetLoader::update(sf::Time budget)
+{
+    sf::Clock clock;
+    for (;;)
+    {
+        Job* job = NULL;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_uploadQueue.empty())
+                job = m_uploadQueue.front();
+            else if (m_jobs.empty())
+                return true;
+        }
+        if (!job || clock.getElapsedTime() >= budget)
+            return false;
+
+        if (!upload(*job, clock, budget))
+            return false;
+
+        // complete, or failed
+        job->promise.set_value(!job->isFailed);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uploadQueue.pop_front();
+        for (std::list<std::unique_ptr<Job> >::iterator it = m_jobs.begin(); it != m_jobs.end(); ++it)
+        {
+            if (it->get() == job)
+            {
+                m_jobs.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+std::size_t AssetLoader::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size();
+}
+
+bool AssetLoader::upload(Job& job, const sf::Clock& clock, sf::Time budget)
+{
+    TRACE_SCOPE("texture upload");
+    if (job.isFailed)
+        return true;
+
+    if (!m_isUploading)
+    {
+        job.image = sf::Image();
+        return true;
+    }
+
+    sf::Vector2u size = job.image.getSize();
+    if (!job.isCreated)
+    {
+        if (!job.texture->create(size.x, size.y))
+        {
+            std::cout << "fail create texture " << job.path << std::endl;
+            job.isFailed = true;
+            return true;
+        }
+        job.isCreated = true;
+    }
+
+    const sf::Uint8* pixels = job.image.getPixelsPtr();
+    while (job.uploadedRows < size.y)
+    {
+        if (clock.getElapsedTime() >= budget)
+            return false;
+        unsigned rows = std::min(UploadRows, size.y - job.uploadedRows);
+        job.texture->update(pixels + static_cast<std::size_t>(job.uploadedRows) * size.x * 4, size.x, rows, 0, job.uploadedRows);
+        job.uploadedRows += rows;
+    }
+
+    // the pixels are on the gpu now
+    job.image = sf::Image();
+    return true;
+}
+
+void AssetLoader::run()
+{
+    Trace::setThreadName("asset loader");
+    for (;;)
+    {
+        Job* job = NULL;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_isRunning && m_decodeQueue.empty())
+                m_wake.wait(lock);
+            if (!m_isRunning)
+                return;
+            job = m_decodeQueue.front();
+            m_decodeQueue.pop_front();
+        }
+
+        bool decoded;
+        {
+            TRACE_SCOPE("decode");
+            decoded = loadResource(job->image, job->path) && job->image.getSize().x > 0;
+        }
+        if (!decoded)
+        {
+            std::cout << "fail load texture " << job->path << std::endl;
+            job->isFailed = true;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uploadQueue.push_back(job);
+    }
+}
@@ -0,0 +1,79 @@
+//============================================================================
+// Name        : AssetLoader.hpp
+// Description : decodes textures on worker threads, uploads them in slices
+//============================================================================
+
+#ifndef ASSETLOADER_INCLUDE
+#define ASSETLOADER_INCLUDE
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/System/Time.hpp>
+
+// Images are decoded by a small pool of threads. The GL upload must happen on
+// the render thread, so update() creates the texture and copies a few rows at
+// a time until its time budget is spent; a 4096x4096 sheet is spread over
+// several frames instead of stalling one. Every request returns a future that
+// becomes true once the texture is complete, false if the file failed to load.
+class AssetLoader
+{
+public:
+    // threads 0 picks one less than the cores, at least one
+    explicit AssetLoader(std::size_t threads = 0);
+    ~AssetLoader();
+
+    // texture must stay alive until the future is ready; the resource pack
+    // is searched before the file system
+    std::shared_future<bool> load(sf::Texture& texture, const std::string& path);
+
+    // false when there is no gl context, e.g. headless runs: images are still
+    // decoded but dropped, and textures stay empty
+    void setUploading(bool uploading);
+
+    // render thread: uploads decoded images for about budget; true when
+    // nothing is left to load
+    bool update(sf::Time budget);
+
+    std::size_t getPendingCount() const;
+
+private:
+    AssetLoader(const AssetLoader&);
+    AssetLoader& operator=(const AssetLoader&);
+
+    static const unsigned UploadRows = 64;
+
+    struct Job
+    {
+        sf::Texture* texture;
+        std::string path;
+        sf::Image image;
+        std::promise<bool> promise;
+        unsigned uploadedRows;
+        bool isCreated;
+        bool isFailed;
+    };
+
+    void run();
+    bool upload(Job& job, const sf::Clock& clock, sf::Time budget);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Job*> m_decodeQueue;
+    std::deque<Job*> m_uploadQueue;
+    std::list<std::unique_ptr<Job> > m_jobs;
+    std::vector<std::thread> m_threads;
+    bool m_isRunning;
+    bool m_isUploading;
+};
+
+#endif // ASSETLOADER_INCLUDE
@@ -0,0 +1,148 @@
+//============================================================================
+// Name        : AssetPack.cpp
+// Description : resources packed in one memory mapped file
+//============================================================================
+
+#include "AssetPack.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+    const std::size_t HeaderSize = 16;
+    const std::size_t EntryHeaderSize = 20;
+
+    template <typename T>
+    T readValue(const unsigned char* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+}
+
+const char AssetPack::Magic[8] = "FCPAK01";
+
+AssetPack::AssetPack() : m_data(NULL), m_size(0), m_timestamp(0)
+{
+
+}
+
+AssetPack::~AssetPack()
+{
+    close();
+}
+
+bool AssetPack::openFromFile(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < HeaderSize)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const unsigned char*>(data);
+    m_size = info.st_size;
+    m_timestamp = static_cast<uint64_t>(info.st_mtime);
+
+    bool valid = std::memcmp(m_data, Magic, sizeof(Magic)) == 0;
+    uint32_t entryCount = valid ? readValue<uint32_t>(m_data + 8) : 0;
+    std::size_t offset = HeaderSize;
+    for (uint32_t i = 0; valid && i < entryCount; ++i)
+    {
+        if (m_size - offset < EntryHeaderSize)
+        {
+            valid = false;
+            break;
+        }
+        uint64_t dataOffset = readValue<uint64_t>(m_data + offset);
+        uint64_t dataSize = readValue<uint64_t>(m_data + offset + 8);
+        uint32_t nameLength = readValue<uint32_t>(m_data + offset + 16);
+        offset += EntryHeaderSize;
+        if (m_size - offset < nameLength || dataOffset > m_size || m_size - dataOffset < dataSize)
+        {
+            valid = false;
+            break;
+        }
+        std::string name(reinterpret_cast<const char*>(m_data + offset), nameLength);
+        offset += nameLength;
+        m_entries[name] = std::make_pair(static_cast<std::size_t>(dataOffset), static_cast<std::size_t>(dataSize));
+    }
+
+    if (!valid)
+    {
+        std::cout << "fail read pack " << path << std::endl;
+        close();
+        return false;
+    }
+
+    std::string::size_type slash = path.find_last_of('/');
+    m_directory = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    return true;
+}
+
+void AssetPack::close()
+{
+    if (m_data)
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    m_data = NULL;
+    m_size = 0;
+    m_timestamp = 0;
+    m_directory.clear();
+    m_entries.clear();
+}
+
+bool AssetPack::isOpen() const
+{
+    return m_data != NULL;
+}
+
+const unsigned char* AssetPack::find(const std::string& path, std::size_t& size) const
+{
+    if (!m_data)
+        return NULL;
+
+    std::map<std::string, std::pair<std::size_t, std::size_t> >::const_iterator it;
+    if (!m_directory.empty() && path.compare(0, m_directory.size(), m_directory) == 0)
+        it = m_entries.find(path.substr(m_directory.size()));
+    else
+        it = m_entries.find(path);
+    if (it == m_entries.end())
+        return NULL;
+
+    size = it->second.second;
+    return m_data + it->second.first;
+}
+
+uint64_t AssetPack::getTimestamp() const
+{
+    return m_timestamp;
+}
+
+std::size_t AssetPack::getEntryCount() const
+{
+    return m_entries.size();
+}
+
+AssetPack& resourcePack()
+{
+    static AssetPack pack;
+    return pack;
+}
@@ -0,0 +1,69 @@
+//============================================================================
+// Name        : AssetPack.hpp
+// Description : resources packed in one memory mapped file
+//============================================================================
+
+#ifndef ASSETPACK_INCLUDE
+#define ASSETPACK_INCLUDE
+
+#include <map>
+#include <string>
+#include <utility>
+#include <stdint.h>
+
+// File layout written by tools/PackResources, all little endian:
+//   header  : char magic[8] = "FCPAK01", uint32 entryCount, uint32 reserved
+//   entries : uint64 offset, uint64 size, uint32 nameLength, char name[nameLength]
+//   data    : the files as they are on disk, each 16 byte aligned
+//
+// Names are relative to the folder of the pack. Files are stored unchanged, so
+// a png is handed to SFML still compressed and decoded straight out of the
+// mapping by loadFromMemory, without opening or copying the file.
+class AssetPack
+{
+public:
+    static const char Magic[8];
+
+    AssetPack();
+    ~AssetPack();
+
+    bool openFromFile(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    // path is a name in the pack or a path inside the folder of the pack,
+    // e.g. resourcePath() + "start.png"; NULL when the pack lacks it. The data
+    // stays valid until close and may be read from any thread
+    const unsigned char* find(const std::string& path, std::size_t& size) const;
+
+    // modification time of the pack file, stamps anything derived from it
+    uint64_t getTimestamp() const;
+
+    std::size_t getEntryCount() const;
+
+private:
+    AssetPack(const AssetPack&);
+    AssetPack& operator=(const AssetPack&);
+
+    const unsigned char* m_data;
+    std::size_t m_size;
+    uint64_t m_timestamp;
+    std::string m_directory;
+    std::map<std::string, std::pair<std::size_t, std::size_t> > m_entries;
+};
+
+// pack the loaders look in before the resource folder, opened by main when
+// assets.pack is installed and empty otherwise
+AssetPack& resourcePack();
+
+// sf::Image, sf::Texture, sf::Font... from the resource pack when it holds
+// path, from the file otherwise
+template <typename T>
+bool loadResource(T& resource, const std::string& path)
+{
+    std::size_t size = 0;
+    const unsigned char* data = resourcePack().find(path, size);
+    return data ? resource.loadFromMemory(data, size) : resource.loadFromFile(path);
+}
+
+#endif // ASSETPACK_INCLUDE
@@ -0,0 +1,163 @@
+//============================================================================
+// Name        : BackgroundModel.cpp
+// Description : running per pixel depth mean/variance, foreground against it
+//============================================================================
+
+#include "BackgroundModel.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const uint16_t InvalidDepth = 2047;
+    const float InitialVariance = 16.f;
+
+    struct Parameters
+    {
+        float rate;
+        float foregroundRate;
+        float threshold2;
+        float minimumVariance;
+    };
+
+    std::size_t applyScalar(const uint16_t* depth, float* mean, float* variance, uint8_t* foreground, std::size_t count, const Parameters& parameters)
+    {
+        std::size_t changed = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            if (depth[i] >= InvalidDepth) {
+                foreground[i] = 0;
+                continue;
+            }
+            float value = depth[i];
+            if (variance[i] < 0.f) {
+                mean[i] = value;
+                variance[i] = InitialVariance;
+                foreground[i] = 0;
+                continue;
+            }
+            float difference = value - mean[i];
+            float difference2 = difference * difference;
+            bool isForeground = difference2 > parameters.threshold2 * std::max(variance[i], parameters.minimumVariance);
+            float rate = isForeground ? parameters.foregroundRate : parameters.rate;
+            mean[i] += rate * difference;
+            variance[i] += rate * (difference2 - variance[i]);
+            foreground[i] = isForeground ? 255 : 0;
+            changed += isForeground;
+        }
+        return changed;
+    }
+
+#if defined(__SSE2__)
+    // four pixels; returns the foreground mask as 32 bit lanes
+    inline __m128i applySSE2(__m128 value, __m128 valid, float* mean, float* variance, const Parameters& parameters)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 m = _mm_loadu_ps(mean);
+        __m128 v = _mm_loadu_ps(variance);
+        __m128 unknown = _mm_cmplt_ps(v, zero);
+
+        __m128 difference = _mm_sub_ps(value, m);
+        __m128 difference2 = _mm_mul_ps(difference, difference);
+        __m128 limit = _mm_mul_ps(_mm_set1_ps(parameters.threshold2), _mm_max_ps(v, _mm_set1_ps(parameters.minimumVariance)));
+        __m128 isForeground = _mm_andnot_ps(unknown, _mm_and_ps(valid, _mm_cmpgt_ps(difference2, limit)));
+
+        __m128 rate = _mm_or_ps(_mm_and_ps(isForeground, _mm_set1_ps(parameters.foregroundRate)), _mm_andnot_ps(isForeground, _mm_set1_ps(parameters.rate)));
+        __m128 newMean = _mm_add_ps(m, _mm_mul_ps(rate, difference));
+        __m128 newVariance = _mm_add_ps(v, _mm_mul_ps(rate, _mm_sub_ps(difference2, v)));
+
+        // first reading: it becomes the mean
+        newMean = _mm_or_ps(_mm_and_ps(unknown, value), _mm_andnot_ps(unknown, newMean));
+        newVariance = _mm_or_ps(_mm_and_ps(unknown, _mm_set1_ps(InitialVariance)), _mm_andnot_ps(unknown, newVariance));
+
+        // no reading: untouched
+        _mm_storeu_ps(mean, _mm_or_ps(_mm_and_ps(valid, newMean), _mm_andnot_ps(valid, m)));
+        _mm_storeu_ps(variance, _mm_or_ps(_mm_and_ps(valid, newVariance), _mm_andnot_ps(valid, v)));
+        return _mm_castps_si128(isForeground);
+    }
+
+    std::size_t applySSE2(const uint16_t* depth, float* mean, float* variance, uint8_t* foreground, std::size_t count, const Parameters& parameters)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i limit = _mm_set1_epi16(InvalidDepth - 1);
+        std::size_t vectorCount = count & ~static_cast<std::size_t>(15);
+        std::size_t changed = 0;
+
+        for (std::size_t i = 0; i < vectorCount; i += 16) {
+            __m128i masks[4];
+            for (int half = 0; half < 2; half++) {
+                __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + i + half * 8));
+                // unsigned depth < 2047 <=> saturating depth - 2046 is zero
+                __m128i valid = _mm_cmpeq_epi16(_mm_subs_epu16(raw, limit), zero);
+                __m128 lowValue = _mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, zero));
+                __m128 highValue = _mm_cvtepi32_ps(_mm_unpackhi_epi16(raw, zero));
+                __m128 lowValid = _mm_castsi128_ps(_mm_unpacklo_epi16(valid, valid));
+                __m128 highValid = _mm_castsi128_ps(_mm_unpackhi_epi16(valid, valid));
+                std::size_t at = i + half * 8;
+                masks[half * 2] = applySSE2(lowValue, lowValid, mean + at, variance + at, parameters);
+                masks[half * 2 + 1] = applySSE2(highValue, highValid, mean + at + 4, variance + at + 4, parameters);
+            }
+            // all ones lanes pack to 255 bytes
+            __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(masks[0], masks[1]), _mm_packs_epi32(masks[2], masks[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(foreground + i), bytes);
+            __m128i sums = _mm_sad_epu8(bytes, zero);
+            changed += (_mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8))) / 255;
+        }
+        return changed + applyScalar(depth + vectorCount, mean + vectorCount, variance + vectorCount, foreground + vectorCount, count - vectorCount, parameters);
+    }
+#endif
+}
+
+BackgroundModel::BackgroundModel(std::size_t pixels) :
+m_mean(pixels, 0.f), m_variance(pixels, -1.f), m_learningRate(0.02f), m_foregroundRatio(0.01f), m_threshold(3.f), m_minimumDeviation(4.f)
+{
+
+}
+
+void BackgroundModel::setLearningRate(float rate)
+{
+    m_learningRate = std::max(0.f, std::min(rate, 1.f));
+}
+
+void BackgroundModel::setForegroundRatio(float ratio)
+{
+    m_foregroundRatio = std::max(0.f, std::min(ratio, 1.f));
+}
+
+void BackgroundModel::setThreshold(float deviations)
+{
+    m_threshold = std::max(0.f, deviations);
+}
+
+void BackgroundModel::setMinimumDeviation(float deviation)
+{
+    m_minimumDeviation = std::max(0.f, deviation);
+}
+
+void BackgroundModel::reset()
+{
+    std::fill(m_variance.begin(), m_variance.end(), -1.f);
+}
+
+std::size_t BackgroundModel::apply(const uint16_t* depth, uint8_t* foreground, std::size_t offset, std::size_t count, bool initialize)
+{
+    float* mean = &m_mean[offset];
+    float* variance = &m_variance[offset];
+    if (initialize)
+        std::fill(variance, variance + count, -1.f);
+
+    Parameters parameters;
+    parameters.rate = m_learningRate;
+    parameters.foregroundRate = m_learningRate * m_foregroundRatio;
+    parameters.threshold2 = m_threshold * m_threshold;
+    parameters.minimumVariance = m_minimumDeviation * m_minimumDeviation;
+
+#if defined(__SSE2__)
+    return applySSE2(depth, mean, variance, foreground, count, parameters);
+#else
+    return applyScalar(depth, mean, variance, foreground, count, parameters);
+#endif
+}
@@ -0,0 +1,54 @@
+//============================================================================
+// Name        : BackgroundModel.hpp
+// Description : running per pixel depth mean/variance, foreground against it
+//============================================================================
+
+#ifndef BACKGROUNDMODEL_INCLUDE
+#define BACKGROUNDMODEL_INCLUDE
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+// Every pixel keeps an exponentially weighted mean and variance of its depth.
+// A reading further than threshold standard deviations from the mean is
+// foreground. Background pixels update the model at learningRate, foreground
+// ones at a small fraction of it, so a visitor standing still stays
+// foreground for minutes while a moved prop fades into the background.
+// Classification and update are one pass over float arrays, SSE2 when
+// available; nothing is allocated per frame.
+class BackgroundModel
+{
+public:
+    explicit BackgroundModel(std::size_t pixels = 640 * 480);
+
+    // fraction of the way the mean moves towards a background reading per frame
+    void setLearningRate(float rate);
+    // foreground pixels learn at rate * ratio
+    void setForegroundRatio(float ratio);
+    // in standard deviations
+    void setThreshold(float deviations);
+    // the deviation never counts as less than this, in depth units, so
+    // a pixel that never flickered is not foreground by one unit
+    void setMinimumDeviation(float deviation);
+
+    // the next frame starts the model again
+    void reset();
+
+    // classifies count pixels starting at offset into the frame: foreground
+    // is 255 or 0, pixels without reading (2047 and above) are background
+    // and leave the model alone. With initialize the readings become the
+    // model and nothing is foreground. Returns the foreground pixels
+    std::size_t apply(const uint16_t* depth, uint8_t* foreground, std::size_t offset, std::size_t count, bool initialize);
+
+private:
+    std::vector<float> m_mean;
+    // negative until the pixel had a reading
+    std::vector<float> m_variance;
+    float m_learningRate;
+    float m_foregroundRatio;
+    float m_threshold;
+    float m_minimumDeviation;
+};
+
+#endif // BACKGROUNDMODEL_INCLUDE
@@ -0,0 +1,130 @@
+//============================================================================
+// Name        : DepthDecimation.cpp
+// Description : 2x/4x pooled depth straight from the 16 bit sensor buffer
+//============================================================================
+
+#include "DepthDecimation.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const uint16_t InvalidDepth = 2047;
+
+    // x / n == (x * Reciprocal[n]) >> 21 for every x < 2^16 and n <= 16, so
+    // the mean needs no division
+    struct Reciprocals
+    {
+        uint32_t value[17];
+
+        Reciprocals()
+        {
+            value[0] = 0;
+            for (uint32_t n = 1; n <= 16; n++)
+                value[n] = ((1u << 21) + n - 1) / n;
+        }
+    };
+
+    const Reciprocals& getReciprocals()
+    {
+        static Reciprocals reciprocals;
+        return reciprocals;
+    }
+
+    // the rows of a block into value (min, or sum) and count, then the columns
+    template <DepthPooling Pooling, int Factor>
+    void poolRow(const uint16_t* depth, int width, uint16_t* output, uint16_t* value, uint16_t* count)
+    {
+        int x = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i limit = _mm_set1_epi16(InvalidDepth - 1);
+        const __m128i invalid = _mm_set1_epi16(InvalidDepth);
+        const __m128i sign = _mm_set1_epi16(static_cast<short>(0x8000));
+        for (; x + 8 <= width; x += 8) {
+            __m128i result = Pooling == DepthPoolingMin ? _mm_xor_si128(invalid, sign) : zero;
+            __m128i valid = zero;
+            for (int y = 0; y < Factor; y++) {
+                __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + static_cast<std::size_t>(y) * width + x));
+                // unsigned depth < 2047 <=> saturating depth - 2046 is zero
+                __m128i isValid = _mm_cmpeq_epi16(_mm_subs_epu16(raw, limit), zero);
+                if (Pooling == DepthPoolingMin) {
+                    // unsigned min through the signed one; invalid readings count as 2047
+                    __m128i clamped = _mm_or_si128(_mm_and_si128(isValid, raw), _mm_andnot_si128(isValid, invalid));
+                    result = _mm_min_epi16(result, _mm_xor_si128(clamped, sign));
+                } else {
+                    result = _mm_add_epi16(result, _mm_and_si128(isValid, raw));
+                    valid = _mm_sub_epi16(valid, isValid);
+                }
+            }
+            if (Pooling == DepthPoolingMin) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(value + x), _mm_xor_si128(result, sign));
+            } else {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(value + x), result);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(count + x), valid);
+            }
+        }
+#endif
+        for (; x < width; x++) {
+            uint16_t result = Pooling == DepthPoolingMin ? InvalidDepth : 0;
+            uint16_t valid = 0;
+            for (int y = 0; y < Factor; y++) {
+                uint16_t raw = depth[static_cast<std::size_t>(y) * width + x];
+                if (raw >= InvalidDepth)
+                    continue;
+                if (Pooling == DepthPoolingMin) {
+                    result = std::min(result, raw);
+                } else {
+                    result += raw;
+                    valid++;
+                }
+            }
+            value[x] = result;
+            count[x] = valid;
+        }
+
+        const uint32_t* reciprocal = getReciprocals().value;
+        int outputWidth = width / Factor;
+        for (x = 0; x < outputWidth; x++) {
+            const uint16_t* v = value + x * Factor;
+            if (Pooling == DepthPoolingMin) {
+                uint16_t result = v[0];
+                for (int i = 1; i < Factor; i++)
+                    result = std::min(result, v[i]);
+                output[x] = result;
+            } else {
+                // at most 16 readings below 2047
+                const uint16_t* c = count + x * Factor;
+                uint32_t sum = 0;
+                uint32_t readings = 0;
+                for (int i = 0; i < Factor; i++) {
+                    sum += v[i];
+                    readings += c[i];
+                }
+                output[x] = readings > 0 ? static_cast<uint16_t>((static_cast<uint64_t>(sum + readings / 2) * reciprocal[readings]) >> 21) : InvalidDepth;
+            }
+        }
+    }
+
+    template <DepthPooling Pooling, int Factor>
+    void decimate(const uint16_t* depth, int width, int height, uint16_t* output, uint16_t* rowBuffer)
+    {
+        int outputWidth = width / Factor;
+        for (int y = 0; y < height / Factor; y++)
+            poolRow<Pooling, Factor>(depth + static_cast<std::size_t>(y) * Factor * width, width, output + static_cast<std::size_t>(y) * outputWidth, rowBuffer, rowBuffer + width);
+    }
+}
+
+void decimateDepth(const uint16_t* depth, int width, int height, int factor, DepthPooling pooling, uint16_t* output, uint16_t* rowBuffer)
+{
+    if (factor == 4)
+        pooling == DepthPoolingMin ? decimate<DepthPoolingMin, 4>(depth, width, height, output, rowBuffer) : decimate<DepthPoolingMean, 4>(depth, width, height, output, rowBuffer);
+    else if (factor == 2)
+        pooling == DepthPoolingMin ? decimate<DepthPoolingMin, 2>(depth, width, height, output, rowBuffer) : decimate<DepthPoolingMean, 2>(depth, width, height, output, rowBuffer);
+    else
+        pooling == DepthPoolingMin ? decimate<DepthPoolingMin, 1>(depth, width, height, output, rowBuffer) : decimate<DepthPoolingMean, 1>(depth, width, height, output, rowBuffer);
+}
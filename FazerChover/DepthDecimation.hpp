@@ -0,0 +1,27 @@
+//============================================================================
+// Name        : DepthDecimation.hpp
+// Description : 2x/4x pooled depth straight from the 16 bit sensor buffer
+//============================================================================
+
+#ifndef DEPTHDECIMATION_INCLUDE
+#define DEPTHDECIMATION_INCLUDE
+
+#include <cstddef>
+#include <stdint.h>
+
+enum DepthPooling
+{
+    DepthPoolingMin,  // nearest reading of the block
+    DepthPoolingMean  // rounded mean of the readings of the block
+};
+
+// Reduces every factor (1, 2 or 4) x factor block of a width x height CV_16UC1 frame to
+// one pixel of output, (width / factor) x (height / factor). Pixels without
+// reading (2047 and above) are left out of the block; a block without any
+// reading becomes 2047. Depth units are unchanged, so thresholds in depth
+// units and fractions of the frame mean the same at every factor. One pass:
+// the rows of a block are pooled with SSE2 when available, then the columns.
+// rowBuffer holds 2 * width values.
+void decimateDepth(const uint16_t* depth, int width, int height, int factor, DepthPooling pooling, uint16_t* output, uint16_t* rowBuffer);
+
+#endif // DEPTHDECIMATION_INCLUDE
@@ -0,0 +1,143 @@
+//============================================================================
+// Name        : DepthFilter.cpp
+// Description : temporal median over the last depth frames, invalid pixels held
+//============================================================================
+
+#include "DepthFilter.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+    {
+        return std::max(std::min(a, b), std::min(std::max(a, b), c));
+    }
+
+    inline uint16_t median5(uint16_t a, uint16_t b, uint16_t c, uint16_t d, uint16_t e)
+    {
+        return median3(e, std::max(std::min(a, b), std::min(c, d)), std::min(std::max(a, b), std::max(c, d)));
+    }
+
+    // valid samples go to slot, invalid ones leave it as it was: the window
+    // holds the same values as before and the median does not move
+    void filterScalar(const uint16_t* depth, uint16_t* history, std::size_t frameSize, std::size_t slot, int length, uint16_t* output, std::size_t begin, std::size_t end)
+    {
+        uint16_t* current = history + slot * frameSize;
+        for (std::size_t i = begin; i < end; i++) {
+            if (depth[i] < DepthFilter::InvalidDepth)
+                current[i] = depth[i];
+            if (length == 3)
+                output[i] = median3(history[i], history[frameSize + i], history[2 * frameSize + i]);
+            else if (length == 5)
+                output[i] = median5(history[i], history[frameSize + i], history[2 * frameSize + i], history[3 * frameSize + i], history[4 * frameSize + i]);
+            else
+                output[i] = current[i];
+        }
+    }
+
+#if defined(__SSE2__)
+    // signed 16 bit min/max are exact here: history values are below 2047
+    inline __m128i median3SSE2(__m128i a, __m128i b, __m128i c)
+    {
+        return _mm_max_epi16(_mm_min_epi16(a, b), _mm_min_epi16(_mm_max_epi16(a, b), c));
+    }
+
+    inline __m128i load(const uint16_t* p)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    std::size_t filterSSE2(const uint16_t* depth, uint16_t* history, std::size_t frameSize, std::size_t slot, int length, uint16_t* output)
+    {
+        const __m128i limit = _mm_set1_epi16(DepthFilter::InvalidDepth - 1);
+        const __m128i zero = _mm_setzero_si128();
+        uint16_t* current = history + slot * frameSize;
+        std::size_t vectorCount = frameSize & ~static_cast<std::size_t>(7);
+
+        for (std::size_t i = 0; i < vectorCount; i += 8) {
+            // unsigned depth < 2047 <=> saturating depth - 2046 is zero
+            __m128i raw = load(depth + i);
+            __m128i valid = _mm_cmpeq_epi16(_mm_subs_epu16(raw, limit), zero);
+            __m128i old = load(current + i);
+            __m128i value = _mm_or_si128(_mm_and_si128(valid, raw), _mm_andnot_si128(valid, old));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(current + i), value);
+
+            __m128i result = value;
+            if (length == 3) {
+                result = median3SSE2(load(history + i), load(history + frameSize + i), load(history + 2 * frameSize + i));
+            } else if (length == 5) {
+                __m128i a = load(history + i);
+                __m128i b = load(history + frameSize + i);
+                __m128i c = load(history + 2 * frameSize + i);
+                __m128i d = load(history + 3 * frameSize + i);
+                __m128i e = load(history + 4 * frameSize + i);
+                __m128i low = _mm_max_epi16(_mm_min_epi16(a, b), _mm_min_epi16(c, d));
+                __m128i high = _mm_min_epi16(_mm_max_epi16(a, b), _mm_max_epi16(c, d));
+                result = median3SSE2(e, low, high);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), result);
+        }
+        return vectorCount;
+    }
+#endif
+}
+
+const uint16_t DepthFilter::InvalidDepth;
+
+DepthFilter::DepthFilter(int width, int height, int length) :
+m_width(width), m_height(height), m_length(1), m_next(0), m_hasHistory(false), m_output(static_cast<std::size_t>(width) * height, InvalidDepth)
+{
+    setLength(length);
+}
+
+void DepthFilter::setLength(int length)
+{
+    m_length = length >= 5 ? 5 : length >= 3 ? 3 : 1;
+    m_history.assign(static_cast<std::size_t>(m_width) * m_height * m_length, 0);
+    reset();
+}
+
+int DepthFilter::getLength() const
+{
+    return m_length;
+}
+
+void DepthFilter::reset()
+{
+    m_next = 0;
+    m_hasHistory = false;
+    std::fill(m_output.begin(), m_output.end(), InvalidDepth);
+}
+
+const uint16_t* DepthFilter::apply(const uint16_t* depth)
+{
+    std::size_t frameSize = m_output.size();
+    uint16_t* history = &m_history[0];
+    uint16_t* output = &m_output[0];
+
+    if (!m_hasHistory) {
+        // the first frame fills the whole history, its median is itself
+        for (std::size_t i = 0; i < frameSize; i++)
+            output[i] = depth[i] < InvalidDepth ? depth[i] : InvalidDepth;
+        for (int slot = 0; slot < m_length; slot++)
+            std::memcpy(history + slot * frameSize, output, frameSize * sizeof(uint16_t));
+        m_hasHistory = true;
+        m_next = m_length > 1 ? 1 : 0;
+        return output;
+    }
+
+    std::size_t done = 0;
+#if defined(__SSE2__)
+    done = filterSSE2(depth, history, frameSize, m_next, m_length, output);
+#endif
+    filterScalar(depth, history, frameSize, m_next, m_length, output, done, frameSize);
+
+    m_next = (m_next + 1) % m_length;
+    return output;
+}
@@ -0,0 +1,49 @@
+//============================================================================
+// Name        : DepthFilter.hpp
+// Description : temporal median over the last depth frames, invalid pixels held
+//============================================================================
+
+#ifndef DEPTHFILTER_INCLUDE
+#define DEPTHFILTER_INCLUDE
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+// Kinect depth flickers by a few units from frame to frame and drops pixels
+// to 2047 (no reading) along edges; both read as motion when frames are
+// compared. Every pixel is replaced by the median of its last length values
+// (1, 3 or 5; 1 turns the filter off). A pixel without reading does not enter
+// the history, which keeps the last valid values however long the dropout
+// lasts, so the pixel keeps its last filtered value. A real change shows up
+// (length - 1) / 2 frames later. One pass, min/max networks in SSE2 when
+// available, nothing allocated per frame.
+class DepthFilter
+{
+public:
+    static const uint16_t InvalidDepth = 2047;
+
+    DepthFilter(int width = 640, int height = 480, int length = 3);
+
+    void setLength(int length);
+    int getLength() const;
+
+    // forgets the history, the next frame starts it again
+    void reset();
+
+    // depth is width x height CV_16UC1 data; the result stays valid until
+    // the next call
+    const uint16_t* apply(const uint16_t* depth);
+
+private:
+    int m_width;
+    int m_height;
+    int m_length;
+    std::size_t m_next;
+    bool m_hasHistory;
+    // length frames back to back, the oldest is overwritten
+    std::vector<uint16_t> m_history;
+    std::vector<uint16_t> m_output;
+};
+
+#endif // DEPTHFILTER_INCLUDE
@@ -0,0 +1,624 @@
+//============================================================================
+// Name        : DepthRecording.cpp
+// Description : compressed, seekable container for recorded depth sessions
+//============================================================================
+
+#include "DepthRecording.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include "Trace.hpp"
+
+namespace
+{
+    const char FileMagic[8] = "FCDEP01";
+    const char IndexMagic[8] = "FCIDX01";
+    const std::size_t HeaderSize = 24;
+    const std::size_t FrameHeaderSize = 16;
+    const std::size_t IndexEntrySize = 24;
+    const std::size_t TrailerSize = 24;
+
+    // the FCRAW01 layout read by ReplayFrameSource
+    const char RawMagic[8] = "FCRAW01";
+    const std::size_t RawRecordHeaderSize = 16;
+    const uint32_t RawHasDepth = 1;
+    const uint32_t RawHasVideo = 2;
+
+    const int BlockSize = 16;
+    const int ParameterBits = 4;
+    const int ZeroBlock = 15;
+    const int EscapeLength = 8;
+    const int ResidualBits = 12;
+    const uint16_t DepthMask = 0x7FF;
+
+    enum FrameType
+    {
+        KeyFrame,   // Rice coded, predicted from the left neighbour
+        DeltaFrame, // Rice coded, predicted from the previous frame
+        PackedFrame // plain 11 bit values
+    };
+
+    template <typename T>
+    T readValue(const unsigned char* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void appendValue(std::vector<uint8_t>& out, T value)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+
+    // most significant bit first
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(std::vector<uint8_t>& out) : m_out(out), m_acc(0), m_bits(0)
+        {
+
+        }
+
+        void write(uint32_t value, int count)
+        {
+            m_acc = (m_acc << count) | value;
+            m_bits += count;
+            while (m_bits >= 8) {
+                m_bits -= 8;
+                m_out.push_back(static_cast<uint8_t>(m_acc >> m_bits));
+            }
+        }
+
+        void flush()
+        {
+            if (m_bits > 0)
+                m_out.push_back(static_cast<uint8_t>(m_acc << (8 - m_bits)));
+            m_bits = 0;
+        }
+
+    private:
+        std::vector<uint8_t>& m_out;
+        uint64_t m_acc;
+        int m_bits;
+    };
+
+    class BitReader
+    {
+    public:
+        BitReader(const unsigned char* data, std::size_t size) : m_data(data), m_end(data + size), m_acc(0), m_bits(0)
+        {
+
+        }
+
+        uint32_t read(int count)
+        {
+            refill();
+            m_bits -= count;
+            return static_cast<uint32_t>(m_acc >> m_bits) & ((1u << count) - 1);
+        }
+
+        // number of leading one bits, capped at EscapeLength, terminating zero consumed
+        int readUnary()
+        {
+            refill();
+            uint32_t window = static_cast<uint32_t>(m_acc >> (m_bits - 32));
+            int ones = (~window == 0) ? 32 : __builtin_clz(~window);
+            if (ones >= EscapeLength) {
+                m_bits -= EscapeLength;
+                return EscapeLength;
+            }
+            m_bits -= ones + 1;
+            return ones;
+        }
+
+        // refill reads ahead, so only bits handed out past the end count
+        bool isOverrun() const
+        {
+            return m_data > m_end && static_cast<std::size_t>(m_data - m_end) * 8 > static_cast<std::size_t>(m_bits);
+        }
+
+    private:
+        void refill()
+        {
+            while (m_bits <= 56) {
+                m_acc = (m_acc << 8) | (m_data < m_end ? *m_data : 0);
+                m_data++;
+                m_bits += 8;
+            }
+        }
+
+        const unsigned char* m_data;
+        const unsigned char* m_end;
+        uint64_t m_acc;
+        int m_bits;
+    };
+
+    inline uint32_t zigzag(int residual)
+    {
+        return (static_cast<uint32_t>(residual) << 1) ^ static_cast<uint32_t>(residual >> 31);
+    }
+
+    inline int unzigzag(uint32_t value)
+    {
+        return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+    }
+
+    inline int predict(const uint16_t* frame, const uint16_t* previous, std::size_t i, int width)
+    {
+        if (previous)
+            return previous[i] & DepthMask;
+        if (i % width != 0)
+            return frame[i - 1] & DepthMask;
+        return i >= static_cast<std::size_t>(width) ? frame[i - width] & DepthMask : 0;
+    }
+
+    // previous == NULL codes a key frame
+    void encodeRice(const uint16_t* frame, const uint16_t* previous, int width, std::size_t count, std::vector<uint8_t>& out)
+    {
+        BitWriter writer(out);
+        uint32_t block[BlockSize];
+
+        for (std::size_t start = 0; start < count; start += BlockSize) {
+            int n = static_cast<int>(count - start < BlockSize ? count - start : BlockSize);
+            uint32_t sum = 0;
+            for (int j = 0; j < n; j++) {
+                std::size_t i = start + j;
+                block[j] = zigzag((frame[i] & DepthMask) - predict(frame, previous, i, width));
+                sum += block[j];
+            }
+
+            // unchanged runs are common in delta frames and cost only the parameter
+            if (sum == 0) {
+                writer.write(ZeroBlock, ParameterBits);
+                continue;
+            }
+
+            // the mean residual bounds the parameter from above, but a single
+            // dropout in the block inflates it: take the cheapest one below
+            int bound = 0;
+            while (bound < ResidualBits - 1 && (static_cast<uint32_t>(n) << (bound + 1)) <= sum)
+                bound++;
+            int k = bound;
+            uint32_t best = ~0u;
+            for (int candidate = bound; candidate >= 0; candidate--) {
+                uint32_t bits = 0;
+                for (int j = 0; j < n; j++) {
+                    uint32_t q = block[j] >> candidate;
+                    bits += q < static_cast<uint32_t>(EscapeLength) ? q + 1 + candidate : EscapeLength + ResidualBits;
+                }
+                if (bits < best) {
+                    best = bits;
+                    k = candidate;
+                }
+            }
+            writer.write(k, ParameterBits);
+
+            for (int j = 0; j < n; j++) {
+                uint32_t q = block[j] >> k;
+                if (q < static_cast<uint32_t>(EscapeLength)) {
+                    writer.write(((1u << q) - 1) << 1, q + 1);
+                    if (k > 0)
+                        writer.write(block[j] & ((1u << k) - 1), k);
+                } else {
+                    writer.write((1u << EscapeLength) - 1, EscapeLength);
+                    writer.write(block[j], ResidualBits);
+                }
+            }
+        }
+        writer.flush();
+    }
+
+    bool decodeRice(const unsigned char* data, std::size_t size, const uint16_t* previous, int width, std::size_t count, uint16_t* frame)
+    {
+        BitReader reader(data, size);
+
+        for (std::size_t start = 0; start < count; start += BlockSize) {
+            std::size_t end = start + BlockSize < count ? start + BlockSize : count;
+            int k = reader.read(ParameterBits);
+            if (k == ZeroBlock) {
+                for (std::size_t i = start; i < end; i++)
+                    frame[i] = static_cast<uint16_t>(predict(frame, previous, i, width));
+                continue;
+            }
+            for (std::size_t i = start; i < end; i++) {
+                int q = reader.readUnary();
+                uint32_t value;
+                if (q < EscapeLength)
+                    value = (static_cast<uint32_t>(q) << k) | (k > 0 ? reader.read(k) : 0);
+                else
+                    value = reader.read(ResidualBits);
+                frame[i] = static_cast<uint16_t>((predict(frame, previous, i, width) + unzigzag(value)) & DepthMask);
+            }
+            if (reader.isOverrun())
+                return false;
+        }
+        return true;
+    }
+
+    std::size_t getPackedSize(std::size_t count)
+    {
+        return (count * 11 + 7) / 8;
+    }
+
+    void encodePacked(const uint16_t* frame, std::size_t count, std::vector<uint8_t>& out)
+    {
+        BitWriter writer(out);
+        for (std::size_t i = 0; i < count; i++)
+            writer.write(frame[i] & DepthMask, 11);
+        writer.flush();
+    }
+
+    bool decodePacked(const unsigned char* data, std::size_t size, std::size_t count, uint16_t* frame)
+    {
+        if (size < getPackedSize(count))
+            return false;
+        BitReader reader(data, size);
+        for (std::size_t i = 0; i < count; i++)
+            frame[i] = static_cast<uint16_t>(reader.read(11));
+        return true;
+    }
+}
+
+////////////////////////////////////////////////////////////
+
+DepthRecorder::DepthRecorder(std::size_t capacity) :
+m_slots(capacity), m_queued(capacity), m_free(capacity), m_isOpen(false), m_isRunning(false), m_droppedFrames(0), m_frameCount(0),
+m_format(Compressed), m_hasVideo(false), m_file(NULL), m_width(0), m_height(0), m_keyInterval(0), m_offset(0), m_isWriteFailed(false)
+{
+
+}
+
+DepthRecorder::~DepthRecorder()
+{
+    close();
+}
+
+bool DepthRecorder::openFromFile(const std::string& path, Format format, int width, int height, int keyInterval)
+{
+    close();
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file)
+        return false;
+
+    m_format = format;
+    m_width = width;
+    m_height = height;
+    m_keyInterval = keyInterval > 0 ? keyInterval : 1;
+    m_previous.assign(static_cast<std::size_t>(width) * height, 0);
+    m_payload.clear();
+    m_payload.reserve(getPackedSize(m_previous.size()) + FrameHeaderSize);
+    m_index.clear();
+    m_isWriteFailed = false;
+    m_droppedFrames = 0;
+    m_frameCount = 0;
+    std::size_t rgbSize = format == Raw ? m_previous.size() * 3 : 0;
+    m_video.assign(rgbSize, 0);
+    m_hasVideo = false;
+
+    std::vector<uint8_t> header;
+    if (format == Raw) {
+        header.assign(RawMagic, RawMagic + sizeof(RawMagic));
+        appendValue<uint32_t>(header, width);
+        appendValue<uint32_t>(header, height);
+    } else {
+        header.assign(FileMagic, FileMagic + sizeof(FileMagic));
+        appendValue<uint32_t>(header, width);
+        appendValue<uint32_t>(header, height);
+        appendValue<uint32_t>(header, m_keyInterval);
+        appendValue<uint32_t>(header, 0);
+    }
+    m_offset = std::fwrite(&header[0], 1, header.size(), m_file);
+    if (m_offset != header.size()) {
+        std::fclose(m_file);
+        m_file = NULL;
+        return false;
+    }
+
+    // every slot free, nothing queued: both queues are empty after close
+    for (std::size_t i = 0; i < m_slots.size(); i++) {
+        m_slots[i].depth.assign(m_previous.size(), 0);
+        m_slots[i].rgb.assign(rgbSize, 0);
+        m_free.tryPush(i);
+    }
+    m_isRunning = true;
+    m_thread = std::thread(&DepthRecorder::run, this);
+    m_isOpen = true;
+    return true;
+}
+
+bool DepthRecorder::isOpen() const
+{
+    return m_isOpen;
+}
+
+DepthRecorder::Format DepthRecorder::getFormat() const
+{
+    return m_format;
+}
+
+bool DepthRecorder::addFrame(const uint16_t* depth, uint64_t timestamp)
+{
+    if (!m_isOpen)
+        return false;
+
+    std::size_t i;
+    if (!m_free.tryPop(i)) {
+        m_droppedFrames++;
+        return false;
+    }
+    Slot& slot = m_slots[i];
+    std::memcpy(&slot.depth[0], depth, slot.depth.size() * sizeof(uint16_t));
+    slot.timestamp = timestamp;
+    slot.hasVideo = m_hasVideo;
+    if (m_hasVideo)
+        std::memcpy(&slot.rgb[0], &m_video[0], m_video.size());
+    m_hasVideo = false;
+    // cannot fail: there are as many queue entries as slots
+    m_queued.tryPush(i);
+    // no lock taken here: the writer also wakes up on its own timeout
+    m_wake.notify_one();
+    return true;
+}
+
+void DepthRecorder::addVideo(const uint8_t* rgb)
+{
+    if (!m_isOpen || m_format != Raw)
+        return;
+    std::memcpy(&m_video[0], rgb, m_video.size());
+    m_hasVideo = true;
+}
+
+void DepthRecorder::run()
+{
+    Trace::setThreadName("recorder");
+    std::size_t i;
+    while (true) {
+        if (m_queued.tryPop(i)) {
+            if (!m_isWriteFailed) {
+                bool ok = m_format == Raw ? writeRawFrame(m_slots[i]) : writeFrame(m_slots[i]);
+                if (!ok) {
+                    std::cout << "fail write recording" << std::endl;
+                    m_isWriteFailed = true;
+                }
+            }
+            m_free.tryPush(i);
+            continue;
+        }
+        if (!m_isRunning)
+            break;
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wake.wait_for(lock, std::chrono::milliseconds(100));
+    }
+}
+
+bool DepthRecorder::writeFrame(const Slot& slot)
+{
+    TRACE_SCOPE("record");
+    const uint16_t* depth = &slot.depth[0];
+    std::size_t count = m_previous.size();
+    bool key = m_index.size() % m_keyInterval == 0;
+
+    m_payload.resize(FrameHeaderSize);
+    encodeRice(depth, key ? NULL : &m_previous[0], m_width, count, m_payload);
+    uint32_t type = key ? KeyFrame : DeltaFrame;
+    if (m_payload.size() - FrameHeaderSize > getPackedSize(count)) {
+        m_payload.resize(FrameHeaderSize);
+        encodePacked(depth, count, m_payload);
+        type = PackedFrame;
+    }
+
+    uint32_t size = static_cast<uint32_t>(m_payload.size() - FrameHeaderSize);
+    std::memcpy(&m_payload[0], &slot.timestamp, 8);
+    std::memcpy(&m_payload[8], &type, 4);
+    std::memcpy(&m_payload[12], &size, 4);
+
+    // indexed only once written, a partial frame would break the index
+    std::size_t written = std::fwrite(&m_payload[0], 1, m_payload.size(), m_file);
+    if (written != m_payload.size())
+        return false;
+
+    IndexEntry entry;
+    entry.offset = m_offset;
+    entry.timestamp = slot.timestamp;
+    entry.keyFrame = type == DeltaFrame ? m_index.back().keyFrame : static_cast<uint32_t>(m_index.size());
+    m_index.push_back(entry);
+    m_offset += written;
+    m_frameCount = m_index.size();
+
+    for (std::size_t i = 0; i < count; i++)
+        m_previous[i] = depth[i] & DepthMask;
+    return true;
+}
+
+bool DepthRecorder::writeRawFrame(const Slot& slot)
+{
+    TRACE_SCOPE("record");
+    // a partial record is ignored on replay, the frame count is rounded down
+    uint32_t flags = RawHasDepth | (slot.hasVideo ? RawHasVideo : 0);
+    uint32_t reserved = 0;
+    bool ok = std::fwrite(&slot.timestamp, 8, 1, m_file) == 1 &&
+        std::fwrite(&flags, 4, 1, m_file) == 1 &&
+        std::fwrite(&reserved, 4, 1, m_file) == 1 &&
+        std::fwrite(&slot.depth[0], sizeof(uint16_t), slot.depth.size(), m_file) == slot.depth.size() &&
+        std::fwrite(&slot.rgb[0], 1, slot.rgb.size(), m_file) == slot.rgb.size();
+    if (!ok)
+        return false;
+    m_offset += RawRecordHeaderSize + slot.depth.size() * sizeof(uint16_t) + slot.rgb.size();
+    m_frameCount++;
+    return true;
+}
+
+bool DepthRecorder::close()
+{
+    if (!m_isOpen)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_isRunning = false;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+    m_isOpen = false;
+    // the writer returned every slot it popped
+    std::size_t i;
+    while (m_free.tryPop(i)) {
+    }
+
+    // raw records are found by their fixed size, there is no index
+    if (m_format == Raw) {
+        bool ok = std::fclose(m_file) == 0 && !m_isWriteFailed;
+        m_file = NULL;
+        return ok;
+    }
+
+    std::vector<uint8_t> index;
+    index.reserve(m_index.size() * IndexEntrySize + TrailerSize);
+    for (std::size_t i = 0; i < m_index.size(); i++) {
+        appendValue<uint64_t>(index, m_index[i].offset);
+        appendValue<uint64_t>(index, m_index[i].timestamp);
+        appendValue<uint32_t>(index, m_index[i].keyFrame);
+        appendValue<uint32_t>(index, 0);
+    }
+    appendValue<uint64_t>(index, m_offset);
+    appendValue<uint32_t>(index, static_cast<uint32_t>(m_index.size()));
+    appendValue<uint32_t>(index, 0);
+    index.insert(index.end(), IndexMagic, IndexMagic + sizeof(IndexMagic));
+
+    // after a failed write the index still covers the frames written whole,
+    // but the trailer must follow the last of them
+    bool ok = !m_isWriteFailed || std::fseek(m_file, static_cast<long>(m_offset), SEEK_SET) == 0;
+    ok = ok && std::fwrite(&index[0], 1, index.size(), m_file) == index.size();
+    ok = std::fclose(m_file) == 0 && ok && !m_isWriteFailed;
+    m_file = NULL;
+    return ok;
+}
+
+std::size_t DepthRecorder::getFrameCount() const
+{
+    return m_frameCount;
+}
+
+uint64_t DepthRecorder::getDroppedFrames() const
+{
+    return m_droppedFrames;
+}
+
+uint64_t DepthRecorder::getBytesWritten() const
+{
+    return m_offset;
+}
+
+////////////////////////////////////////////////////////////
+
+DepthRecording::DepthRecording() :
+m_data(NULL), m_size(0), m_index(NULL), m_width(0), m_height(0), m_frameCount(0), m_decodedFrame(0)
+{
+
+}
+
+bool DepthRecording::isRecording(const unsigned char* data, std::size_t size)
+{
+    return size >= HeaderSize + TrailerSize && std::memcmp(data, FileMagic, sizeof(FileMagic)) == 0;
+}
+
+bool DepthRecording::openFromMemory(const unsigned char* data, std::size_t size)
+{
+    m_data = NULL;
+    m_frameCount = 0;
+    if (!isRecording(data, size))
+        return false;
+
+    const unsigned char* trailer = data + size - TrailerSize;
+    if (std::memcmp(trailer + 16, IndexMagic, sizeof(IndexMagic)) != 0)
+        return false;
+
+    uint64_t indexOffset = readValue<uint64_t>(trailer);
+    std::size_t frameCount = readValue<uint32_t>(trailer + 8);
+    if (indexOffset < HeaderSize || indexOffset + frameCount * IndexEntrySize + TrailerSize != size)
+        return false;
+
+    m_data = data;
+    m_size = size;
+    m_index = data + indexOffset;
+    m_width = readValue<uint32_t>(data + 8);
+    m_height = readValue<uint32_t>(data + 12);
+    m_frameCount = frameCount;
+    m_decoded.assign(static_cast<std::size_t>(m_width) * m_height, 0);
+    m_decodedFrame = m_frameCount;
+    return true;
+}
+
+int DepthRecording::getWidth() const
+{
+    return m_width;
+}
+
+int DepthRecording::getHeight() const
+{
+    return m_height;
+}
+
+std::size_t DepthRecording::getFrameCount() const
+{
+    return m_frameCount;
+}
+
+uint64_t DepthRecording::getTimestamp(std::size_t n) const
+{
+    return readValue<uint64_t>(m_index + n * IndexEntrySize + 8);
+}
+
+const uint16_t* DepthRecording::decodeFrame(std::size_t n)
+{
+    if (n >= m_frameCount)
+        return NULL;
+    if (n == m_decodedFrame)
+        return &m_decoded[0];
+
+    // continue from the frame already decoded when it lies on the way to n
+    std::size_t keyFrame = readValue<uint32_t>(m_index + n * IndexEntrySize + 16);
+    std::size_t first = keyFrame;
+    if (m_decodedFrame < n && m_decodedFrame >= keyFrame)
+        first = m_decodedFrame + 1;
+
+    for (std::size_t i = first; i <= n; i++) {
+        if (!decodeSingle(i)) {
+            m_decodedFrame = m_frameCount;
+            return NULL;
+        }
+        m_decodedFrame = i;
+    }
+    return &m_decoded[0];
+}
+
+bool DepthRecording::decodeSingle(std::size_t n)
+{
+    uint64_t offset = readValue<uint64_t>(m_index + n * IndexEntrySize);
+    if (offset + FrameHeaderSize > static_cast<uint64_t>(m_index - m_data))
+        return false;
+
+    const unsigned char* frame = m_data + offset;
+    uint32_t type = readValue<uint32_t>(frame + 8);
+    std::size_t size = readValue<uint32_t>(frame + 12);
+    const unsigned char* payload = frame + FrameHeaderSize;
+    if (payload + size > m_index)
+        return false;
+
+    uint16_t* output = &m_decoded[0];
+    switch (type) {
+        case KeyFrame:
+            return decodeRice(payload, size, NULL, m_width, m_decoded.size(), output);
+        case DeltaFrame:
+            // in place: each pixel is read from the previous frame before it is overwritten
+            return decodeRice(payload, size, output, m_width, m_decoded.size(), output);
+        case PackedFrame:
+            return decodePacked(payload, size, m_decoded.size(), output);
+    }
+    return false;
+}
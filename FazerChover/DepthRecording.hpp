@@ -0,0 +1,162 @@
+//============================================================================
+// Name        : DepthRecording.hpp
+// Description : compressed, seekable container for recorded depth sessions
+//============================================================================
+
+#ifndef DEPTHRECORDING_INCLUDE
+#define DEPTHRECORDING_INCLUDE
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#include "SpscQueue.hpp"
+
+// File layout, all little endian:
+//   header  : char magic[8] = "FCDEP01", uint32 width, uint32 height,
+//             uint32 keyInterval, uint32 reserved
+//   frames  : uint64 timestamp (microseconds), uint32 type, uint32 size,
+//             uint8 payload[size]
+//   index   : per frame uint64 offset, uint64 timestamp, uint32 keyFrame,
+//             uint32 reserved
+//   trailer : uint64 indexOffset, uint32 frameCount, uint32 reserved,
+//             char magic[8] = "FCIDX01"
+//
+// Key frames predict each pixel from its left neighbour, delta frames from
+// the same pixel in the previous frame. Residuals are zigzag mapped and Rice
+// coded in blocks of 16 pixels with the per block parameter that codes the
+// block shortest; an unchanged block costs 4 bits. A frame whose coded size
+// would exceed plain 11 bit packing is stored packed instead.
+//
+// The Raw format writes the uncompressed depth and rgb records described in
+// ReplayFrameSource.hpp ("FCRAW01") instead, about 1.5MB per frame.
+//
+// addFrame is called from the sensor callback and never waits: it copies the
+// frame into one of capacity preallocated slots and a writer thread encodes
+// and writes it. When every slot is still queued the frame is dropped. Only
+// one thread may add frames and video.
+class DepthRecorder
+{
+public:
+    enum Format
+    {
+        Compressed, // depth only, FCDEP01
+        Raw         // depth and rgb, FCRAW01
+    };
+
+    explicit DepthRecorder(std::size_t capacity = 8);
+    ~DepthRecorder();
+
+    // also starts the writer thread. keyInterval is ignored by Raw
+    bool openFromFile(const std::string& path, Format format = Compressed, int width = 640, int height = 480, int keyInterval = 30);
+    bool isOpen() const;
+    Format getFormat() const;
+
+    // depth holds width*height 11 bit values; false when dropped
+    bool addFrame(const uint16_t* depth, uint64_t timestamp);
+
+    // Raw only: rgb (width*height*3 bytes) goes with the next frame added.
+    // A frame with no new video since the previous one is recorded without
+    // any (HasVideo clear)
+    void addVideo(const uint8_t* rgb);
+
+    // writes what is still queued and the frame index, the file is unusable
+    // until this is called. No addFrame may run concurrently: stop the
+    // stream feeding the recorder first
+    bool close();
+
+    std::size_t getFrameCount() const;
+    uint64_t getDroppedFrames() const;
+    uint64_t getBytesWritten() const;
+
+private:
+    DepthRecorder(const DepthRecorder&);
+    DepthRecorder& operator=(const DepthRecorder&);
+
+    struct IndexEntry
+    {
+        uint64_t offset;
+        uint64_t timestamp;
+        uint32_t keyFrame;
+    };
+
+    struct Slot
+    {
+        std::vector<uint16_t> depth;
+        std::vector<uint8_t> rgb; // Raw only
+        bool hasVideo;
+        uint64_t timestamp;
+    };
+
+    void run();
+    bool writeFrame(const Slot& slot);
+    bool writeRawFrame(const Slot& slot);
+
+    // slots go to the writer through m_queued and come back through m_free
+    std::vector<Slot> m_slots;
+    SpscQueue<std::size_t> m_queued;
+    SpscQueue<std::size_t> m_free;
+    std::atomic<bool> m_isOpen;
+    std::atomic<bool> m_isRunning;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+    std::atomic<uint64_t> m_droppedFrames;
+    std::atomic<std::size_t> m_frameCount;
+    Format m_format;
+
+    // adding thread only: the latest video not recorded yet
+    std::vector<uint8_t> m_video;
+    bool m_hasVideo;
+
+    // writer thread only while open
+    std::FILE* m_file;
+    int m_width;
+    int m_height;
+    int m_keyInterval;
+    std::atomic<uint64_t> m_offset;
+    bool m_isWriteFailed;
+    std::vector<uint16_t> m_previous;
+    std::vector<uint8_t> m_payload;
+    std::vector<IndexEntry> m_index;
+};
+
+// Reads a recording from memory, typically a mapped file. Any frame is found
+// through the index in constant time and decoded from at most keyInterval
+// frames; decoding frames in order costs a single frame each.
+class DepthRecording
+{
+public:
+    DepthRecording();
+
+    static bool isRecording(const unsigned char* data, std::size_t size);
+
+    bool openFromMemory(const unsigned char* data, std::size_t size);
+
+    int getWidth() const;
+    int getHeight() const;
+    std::size_t getFrameCount() const;
+    uint64_t getTimestamp(std::size_t n) const;
+
+    // returns width*height values, valid until the next decodeFrame; NULL on corrupt data
+    const uint16_t* decodeFrame(std::size_t n);
+
+private:
+    bool decodeSingle(std::size_t n);
+
+    const unsigned char* m_data;
+    std::size_t m_size;
+    const unsigned char* m_index;
+    int m_width;
+    int m_height;
+    std::size_t m_frameCount;
+    std::size_t m_decodedFrame;
+    std::vector<uint16_t> m_decoded;
+};
+
+#endif // DEPTHRECORDING_INCLUDE
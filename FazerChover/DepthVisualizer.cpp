@@ -0,0 +1,142 @@
+//============================================================================
+// Name        : DepthVisualizer.cpp
+// Description : false color view of raw kinect depth, drawn as an overlay
+//============================================================================
+
+#include "DepthVisualizer.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    const unsigned DepthValues = 2048;
+
+    // 0x7ff is what the sensor reports when it sees nothing
+    const uint16_t InvalidDepth = DepthValues - 1;
+
+    struct GammaTable
+    {
+        GammaTable()
+        {
+            for (unsigned i = 0; i < DepthValues; i++) {
+                float v = i / 2048.0;
+                v = std::pow(v, 3) * 6;
+                values[i] = v * 6 * 256;
+            }
+        }
+
+        uint16_t values[DepthValues];
+    };
+
+    // bytes in texture order whatever the host endianness
+    uint32_t packColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+    {
+        uint8_t bytes[4] = {r, g, b, a};
+        uint32_t color;
+        std::memcpy(&color, bytes, sizeof(color));
+        return color;
+    }
+
+    // libfreenect glview colormap: white through red, yellow, green, cyan,
+    // blue to black with distance
+    uint32_t falseColor(uint16_t gamma)
+    {
+        uint8_t band = gamma & 0xff;
+        switch (gamma >> 8) {
+            case 0: return packColor(255, 255 - band, 255 - band, 255);
+            case 1: return packColor(255, band, 0, 255);
+            case 2: return packColor(255 - band, 255, 0, 255);
+            case 3: return packColor(0, 255, band, 255);
+            case 4: return packColor(0, 255 - band, 255, 255);
+            case 5: return packColor(0, 0, 255 - band, 255);
+            default: return packColor(0, 0, 0, 255);
+        }
+    }
+}
+
+const uint16_t* getDepthGamma()
+{
+    static const GammaTable table;
+    return table.values;
+}
+
+DepthVisualizer::DepthVisualizer(int width, int height) :
+m_width(width), m_height(height), m_colors(DepthValues), m_highlight(packColor(255, 0, 255, 255)), m_motionWidth(0), m_pixels(width * height), m_hasTexture(false)
+{
+    const uint16_t* gamma = getDepthGamma();
+    for (unsigned i = 0; i < DepthValues; i++)
+        m_colors[i] = falseColor(gamma[i]);
+    m_colors[InvalidDepth] = packColor(0, 0, 0, 255);
+}
+
+void DepthVisualizer::setHighlight(const sf::Color& color)
+{
+    m_highlight = packColor(color.r, color.g, color.b, color.a);
+}
+
+bool DepthVisualizer::update(const uint16_t* depth, const uint8_t* motion, int motionWidth, int motionHeight)
+{
+    if (!m_hasTexture) {
+        if (!m_texture.create(m_width, m_height)) {
+            std::cout << "fail create depth texture" << std::endl;
+            return false;
+        }
+        m_sprite.setTexture(m_texture, true);
+        m_hasTexture = true;
+    }
+    colorize(depth, motion, motionWidth, motionHeight, &m_pixels[0]);
+    m_texture.update(reinterpret_cast<const sf::Uint8*>(&m_pixels[0]));
+    return true;
+}
+
+void DepthVisualizer::colorize(const uint16_t* depth, const uint8_t* motion, int motionWidth, int motionHeight, uint32_t* rgba)
+{
+    const uint32_t* colors = &m_colors[0];
+    if (!motion || motionWidth <= 0 || motionHeight <= 0) {
+        std::size_t count = static_cast<std::size_t>(m_width) * m_height;
+        for (std::size_t i = 0; i < count; i++) {
+            uint16_t d = depth[i];
+            rgba[i] = colors[d < InvalidDepth ? d : InvalidDepth];
+        }
+        return;
+    }
+
+    if (motionWidth != m_motionWidth) {
+        m_motionColumns.resize(m_width);
+        for (int x = 0; x < m_width; x++)
+            m_motionColumns[x] = x * motionWidth / m_width;
+        m_motionWidth = motionWidth;
+    }
+    const int* columns = &m_motionColumns[0];
+
+    for (int y = 0; y < m_height; y++) {
+        const uint16_t* src = depth + static_cast<std::size_t>(y) * m_width;
+        const uint8_t* moved = motion + static_cast<std::size_t>(y * motionHeight / m_height) * motionWidth;
+        uint32_t* dst = rgba + static_cast<std::size_t>(y) * m_width;
+        for (int x = 0; x < m_width; x++) {
+            uint16_t d = src[x];
+            uint32_t color = colors[d < InvalidDepth ? d : InvalidDepth];
+            dst[x] = moved[columns[x]] ? m_highlight : color;
+        }
+    }
+}
+
+int DepthVisualizer::getWidth() const
+{
+    return m_width;
+}
+
+int DepthVisualizer::getHeight() const
+{
+    return m_height;
+}
+
+void DepthVisualizer::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    if (!m_hasTexture)
+        return;
+    states.transform *= getTransform();
+    target.draw(m_sprite, states);
+}
@@ -0,0 +1,66 @@
+//============================================================================
+// Name        : DepthVisualizer.hpp
+// Description : false color view of raw kinect depth, drawn as an overlay
+//============================================================================
+
+#ifndef DEPTHVISUALIZER_INCLUDE
+#define DEPTHVISUALIZER_INCLUDE
+
+#include <vector>
+#include <stdint.h>
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Transformable.hpp>
+
+// gamma curve of the libfreenect samples, 2048 entries: raw 11 bit depth to
+// 0..9202 (6 * 6 * 256 * (i / 2048)^3). The colormap has six 256 step bands,
+// 0..0x5ff; past that, raw 1128 and up, far readings render black
+const uint16_t* getDepthGamma();
+
+// The gamma curve and the colormap are folded into a single 2048 entry RGBA
+// table, so a frame is one lookup per pixel straight into the buffer that is
+// uploaded to the texture. Pixels where the detector saw motion are painted
+// in the highlight color in the same pass.
+class DepthVisualizer : public sf::Drawable, public sf::Transformable
+{
+public:
+    explicit DepthVisualizer(int width = 640, int height = 480);
+
+    void setHighlight(const sf::Color& color);
+
+    // depth is the raw width x height frame; motion, when not NULL, is
+    // nonzero where the detector saw motion, at motionWidth x motionHeight
+    // (the detection size). Creates the texture on first use, false when
+    // that fails
+    bool update(const uint16_t* depth, const uint8_t* motion = NULL, int motionWidth = 0, int motionHeight = 0);
+
+    // the same pass into any width x height RGBA buffer, no texture needed
+    void colorize(const uint16_t* depth, const uint8_t* motion, int motionWidth, int motionHeight, uint32_t* rgba);
+
+    int getWidth() const;
+    int getHeight() const;
+
+private:
+    DepthVisualizer(const DepthVisualizer&);
+    DepthVisualizer& operator=(const DepthVisualizer&);
+
+    virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+
+    int m_width;
+    int m_height;
+    std::vector<uint32_t> m_colors;
+    uint32_t m_highlight;
+    // motion column of every depth column, for the current motion width
+    std::vector<int> m_motionColumns;
+    int m_motionWidth;
+    std::vector<uint32_t> m_pixels;
+    sf::Texture m_texture;
+    sf::Sprite m_sprite;
+    bool m_hasTexture;
+};
+
+#endif // DEPTHVISUALIZER_INCLUDE
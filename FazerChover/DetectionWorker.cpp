@@ -0,0 +1,140 @@
+//============================================================================
+// Name        : DetectionWorker.cpp
+// Description : motion detection on its own thread at the sensor rate
+//============================================================================
+
+#include "DetectionWorker.hpp"
+
+#include <cstring>
+
+#include <opencv2/core/core.hpp>
+
+#include "AllocationCounter.hpp"
+#include "Trace.hpp"
+
+DetectionWorker::DetectionWorker(FrameSource& source, std::size_t queueCapacity) :
+m_source(source), m_detector(640, 480), m_samples(queueCapacity), m_droppedSamples(0), m_allocatingFrames(0), m_isDebugging(false), m_isRunning(false)
+{
+    
+}
+
+DetectionWorker::~DetectionWorker()
+{
+    stop();
+}
+
+MotionDetector& DetectionWorker::getDetector()
+{
+    return m_detector;
+}
+
+void DetectionWorker::start()
+{
+    if (m_isRunning)
+        return;
+    // the detection size is final once started
+    for (std::size_t i = 0; i < 3; i++) {
+        MotionDebugFrame& frame = m_debugFrames.getSlot(i);
+        frame.depth.assign(640 * 480, 0);
+        frame.motionWidth = m_detector.getWidth();
+        frame.motionHeight = m_detector.getHeight();
+        frame.motion.assign(frame.motionWidth * frame.motionHeight, 0);
+    }
+    m_isRunning = true;
+    m_thread = std::thread(&DetectionWorker::run, this);
+}
+
+void DetectionWorker::stop()
+{
+    m_isRunning = false;
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void DetectionWorker::run()
+{
+    Trace::setThreadName("detection");
+    uint64_t frames = 0;
+    // one "sensor wait" per delivered frame, not per poll: ~30 failed polls
+    // a frame would push the stages out of the trace ring
+    uint64_t waitStart = Trace::now();
+    while (m_isRunning) {
+        if (!m_source.getDepth(m_depth)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        Trace::getBuffer().add("sensor wait", waitStart, Trace::now());
+        
+        MotionSample sample;
+        sample.time = std::chrono::steady_clock::now();
+        // the first frames may still allocate: trace buffer, lazy tables
+        uint64_t allocations = AllocationCounter::getCount();
+        m_detector.process(m_depth.ptr<uint16_t>(), sample);
+        if (++frames > 2 && AllocationCounter::getCount() != allocations)
+            m_allocatingFrames++;
+        
+        if (m_isDebugging) {
+            // copies only, coloring is left to the render thread
+            TRACE_SCOPE("debug frame");
+            MotionDebugFrame& frame = m_debugFrames.getBackBuffer();
+            std::memcpy(&frame.depth[0], m_depth.ptr<uint16_t>(), frame.depth.size() * sizeof(uint16_t));
+            const uint8_t* current = m_detector.getCurrent();
+            if (m_detector.getZones().getBackgroundModel()) {
+                std::memcpy(&frame.motion[0], current, frame.motion.size());
+            } else {
+                const uint8_t* previous = m_detector.getPrevious();
+                for (std::size_t i = 0; i < frame.motion.size(); i++)
+                    frame.motion[i] = current[i] != previous[i];
+            }
+            m_debugFrames.publish();
+        }
+        
+        m_detectLatency.add(std::chrono::steady_clock::now() - sample.time);
+        if (!m_samples.tryPush(sample))
+            m_droppedSamples++;
+        waitStart = Trace::now();
+    }
+}
+
+bool DetectionWorker::pollSample(MotionSample& sample)
+{
+    if (!m_samples.tryPop(sample))
+        return false;
+    m_handoffLatency.add(std::chrono::steady_clock::now() - sample.time);
+    return true;
+}
+
+const MotionDebugFrame* DetectionWorker::pollDebugFrame()
+{
+    return m_debugFrames.claim() ? &m_debugFrames.getFrontBuffer() : NULL;
+}
+
+void DetectionWorker::setDebugging(bool debugging)
+{
+    m_isDebugging = debugging;
+}
+
+const StageLatency& DetectionWorker::getDetectLatency() const
+{
+    return m_detectLatency;
+}
+
+const StageLatency& DetectionWorker::getHandoffLatency() const
+{
+    return m_handoffLatency;
+}
+
+std::size_t DetectionWorker::getQueueSize() const
+{
+    return m_samples.getSize();
+}
+
+uint64_t DetectionWorker::getDroppedSamples() const
+{
+    return m_droppedSamples;
+}
+
+uint64_t DetectionWorker::getAllocatingFrames() const
+{
+    return m_allocatingFrames;
+}
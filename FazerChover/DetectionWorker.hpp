@@ -0,0 +1,84 @@
+//============================================================================
+// Name        : DetectionWorker.hpp
+// Description : motion detection on its own thread at the sensor rate
+//============================================================================
+
+#ifndef DETECTIONWORKER_INCLUDE
+#define DETECTIONWORKER_INCLUDE
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "FrameSource.hpp"
+#include "MotionDetector.hpp"
+#include "SpscQueue.hpp"
+#include "StageLatency.hpp"
+#include "TripleBuffer.hpp"
+
+// debug view of the last processed frame, only produced while debugging
+struct MotionDebugFrame
+{
+    std::vector<uint16_t> depth;     // raw sensor frame
+    std::vector<uint8_t> motion;     // nonzero where motion was counted
+    int motionWidth;                 // detection size
+    int motionHeight;
+};
+
+// Pulls depth frames from the source as soon as they arrive, runs them
+// through a MotionDetector and hands the MotionSample to the render thread
+// through a bounded queue. Samples are dropped (and counted) when the queue
+// is full.
+class DetectionWorker
+{
+public:
+    explicit DetectionWorker(FrameSource& source, std::size_t queueCapacity = 64);
+    ~DetectionWorker();
+    
+    // setup, before start
+    MotionDetector& getDetector();
+    
+    void start();
+    void stop();
+    
+    // render thread
+    bool pollSample(MotionSample& sample);
+    // latest debug frame if a new one was published, NULL otherwise; valid
+    // until the next call
+    const MotionDebugFrame* pollDebugFrame();
+    void setDebugging(bool debugging);
+    
+    // time from depth frame arrival to sample queued, and to sample polled
+    // by the render thread
+    const StageLatency& getDetectLatency() const;
+    const StageLatency& getHandoffLatency() const;
+    std::size_t getQueueSize() const;
+    uint64_t getDroppedSamples() const;
+    // frames after the first ones on which the detector allocated, always 0
+    // unless built with FAZERCHOVER_COUNT_ALLOCATIONS (see AllocationCounter)
+    uint64_t getAllocatingFrames() const;
+    
+private:
+    DetectionWorker(const DetectionWorker&);
+    DetectionWorker& operator=(const DetectionWorker&);
+    
+    void run();
+    
+    FrameSource& m_source;
+    MotionDetector m_detector;
+    cv::Mat m_depth;
+    SpscQueue<MotionSample> m_samples;
+    TripleBuffer<MotionDebugFrame> m_debugFrames;
+    StageLatency m_detectLatency;
+    StageLatency m_handoffLatency;
+    std::atomic<uint64_t> m_droppedSamples;
+    std::atomic<uint64_t> m_allocatingFrames;
+    std::atomic<bool> m_isDebugging;
+    std::atomic<bool> m_isRunning;
+    std::thread m_thread;
+};
+
+#endif // DETECTIONWORKER_INCLUDE
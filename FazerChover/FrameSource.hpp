@@ -0,0 +1,39 @@
+//============================================================================
+// Name        : FrameSource.hpp
+// Description : depth/rgb frame provider (live Kinect or recorded session)
+//============================================================================
+
+#ifndef FRAMESOURCE_INCLUDE
+#define FRAMESOURCE_INCLUDE
+
+#include <opencv2/core/core.hpp>
+
+class FrameSource
+{
+public:
+    virtual ~FrameSource() {}
+    
+    // start only streams depth; video is captured while it has subscribers
+    virtual void start() = 0;
+    virtual void stop() = 0;
+    
+    // render thread; every subscribeVideo is matched by an unsubscribeVideo.
+    // The first frames after the stream starts are dropped while the camera
+    // settles, so subscribe about a second before a frame is needed
+    virtual void subscribeVideo() = 0;
+    virtual void unsubscribeVideo() = 0;
+    
+    // 640x480 CV_8UC3 in BGR order; false when there is no new frame
+    virtual bool getVideo(cv::Mat& output) = 0;
+    
+    // the same frame in the sensor's RGB order, without conversion. output
+    // may view the source's own memory, valid until the next getVideo or
+    // getVideoRgb
+    virtual bool getVideoRgb(cv::Mat& output) = 0;
+    
+    // 640x480 CV_16UC1 11 bit depth; false when there is no new frame.
+    // output may view the source's own memory, valid until the next getDepth
+    virtual bool getDepth(cv::Mat& output) = 0;
+};
+
+#endif // FRAMESOURCE_INCLUDE
@@ -0,0 +1,73 @@
+//============================================================================
+// Name        : FrameTable.hpp
+// Description : compile-time frame tables for Animation
+//============================================================================
+
+#ifndef FRAMETABLE_INCLUDE
+#define FRAMETABLE_INCLUDE
+
+#include <cstddef>
+
+// Same fields as sf::IntRect, but a literal type so tables can be constexpr
+// and live in read only memory.
+struct FrameRect
+{
+    int left;
+    int top;
+    int width;
+    int height;
+};
+
+template <std::size_t N>
+struct FrameTable
+{
+    FrameRect frames[N];
+
+    constexpr std::size_t size() const
+    {
+        return N;
+    }
+};
+
+namespace FrameTableDetail
+{
+    template <std::size_t... I>
+    struct Indices
+    {
+
+    };
+
+    template <std::size_t N, std::size_t... I>
+    struct MakeIndices : MakeIndices<N - 1, N - 1, I...>
+    {
+
+    };
+
+    template <std::size_t... I>
+    struct MakeIndices<0, I...>
+    {
+        typedef Indices<I...> Type;
+    };
+
+    constexpr FrameRect gridFrame(int width, int height, int columns, int left, int top, std::size_t i)
+    {
+        return FrameRect{left + static_cast<int>(i % columns) * width, top + static_cast<int>(i / columns) * height, width, height};
+    }
+
+    template <std::size_t N, std::size_t... I>
+    constexpr FrameTable<N> makeGrid(int width, int height, int columns, int left, int top, std::size_t first, Indices<I...>)
+    {
+        return FrameTable<N>{{gridFrame(width, height, columns, left, top, first + I)...}};
+    }
+}
+
+// N cells of width x height read row-major from a sheet with the given number
+// of columns, starting at cell first of the grid whose origin is (left, top):
+//   constexpr FrameTable<16> rain = gridFrames<16>(222, 170, 18);
+template <std::size_t N>
+constexpr FrameTable<N> gridFrames(int width, int height, int columns, int left = 0, int top = 0, std::size_t first = 0)
+{
+    return FrameTableDetail::makeGrid<N>(width, height, columns, left, top, first, typename FrameTableDetail::MakeIndices<N>::Type());
+}
+
+#endif // FRAMETABLE_INCLUDE
@@ -0,0 +1,80 @@
+//============================================================================
+// Name        : HeadlessTarget.cpp
+// Description : stands in for the window when there is no display
+//============================================================================
+
+#include "HeadlessTarget.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+HeadlessTarget::HeadlessTarget(unsigned width, unsigned height) :
+m_view(sf::FloatRect(0, 0, static_cast<float>(width), static_cast<float>(height))), m_boundTexture(NULL), m_drawCalls(0), m_vertexCount(0), m_textureBinds(0), m_frameStart(std::chrono::steady_clock::now())
+{
+
+}
+
+const sf::View& HeadlessTarget::getView() const
+{
+    return m_view;
+}
+
+void HeadlessTarget::draw(const SpriteBatch& batch)
+{
+    for (std::size_t i = 0; i < batch.getDrawCalls(); ++i)
+    {
+        // like sfml, a texture already bound is not bound again
+        if (batch.getTexture(i) != m_boundTexture)
+        {
+            m_boundTexture = batch.getTexture(i);
+            ++m_textureBinds;
+        }
+        m_vertexCount += batch.getVertexCount(i);
+        ++m_drawCalls;
+    }
+}
+
+void HeadlessTarget::display()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    m_frameTimes.push_back(std::chrono::duration_cast<std::chrono::microseconds>(now - m_frameStart).count());
+    m_frameStart = now;
+    m_sorted.clear();
+}
+
+std::size_t HeadlessTarget::getFrameCount() const
+{
+    return m_frameTimes.size();
+}
+
+uint64_t HeadlessTarget::getFrameTime(double percentile) const
+{
+    if (m_frameTimes.empty())
+        return 0;
+
+    if (m_sorted.empty())
+    {
+        m_sorted = m_frameTimes;
+        std::sort(m_sorted.begin(), m_sorted.end());
+    }
+
+    // nearest rank
+    double rank = std::ceil(std::max(0.0, std::min(100.0, percentile)) / 100.0 * m_sorted.size());
+    std::size_t index = rank < 1.0 ? 0 : static_cast<std::size_t>(rank) - 1;
+    return m_sorted[std::min(index, m_sorted.size() - 1)];
+}
+
+void HeadlessTarget::report(std::ostream& stream) const
+{
+    std::size_t frames = getFrameCount();
+    stream << "frames " << frames
+           << "  frame p50 " << getFrameTime(50) << "us p90 " << getFrameTime(90) << "us p99 " << getFrameTime(99)
+           << "us p99.9 " << getFrameTime(99.9) << "us max " << getFrameTime(100) << "us";
+    if (frames > 0)
+    {
+        stream << "  per frame draws " << static_cast<double>(m_drawCalls) / frames
+               << " vertices " << static_cast<double>(m_vertexCount) / frames
+               << " binds " << static_cast<double>(m_textureBinds) / frames;
+    }
+    stream << std::endl;
+}
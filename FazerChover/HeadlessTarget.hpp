@@ -0,0 +1,52 @@
+//============================================================================
+// Name        : HeadlessTarget.hpp
+// Description : stands in for the window when there is no display
+//============================================================================
+
+#ifndef HEADLESSTARGET_INCLUDE
+#define HEADLESSTARGET_INCLUDE
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/View.hpp>
+
+#include "SpriteBatch.hpp"
+
+// A null render target: batches drawn to it go nowhere, but the draw calls,
+// vertices and texture binds they would have cost are counted. display()
+// closes a frame and keeps its CPU time, from the previous display, so the
+// whole main loop is measured and reported as percentiles.
+class HeadlessTarget
+{
+public:
+    explicit HeadlessTarget(unsigned width, unsigned height);
+
+    const sf::View& getView() const;
+
+    void draw(const SpriteBatch& batch);
+    void display();
+
+    std::size_t getFrameCount() const;
+
+    // microseconds, percentile in [0, 100]
+    uint64_t getFrameTime(double percentile) const;
+
+    // frame time percentiles and the per frame averages of the counters
+    void report(std::ostream& stream) const;
+
+private:
+    sf::View m_view;
+    const sf::Texture* m_boundTexture;
+    uint64_t m_drawCalls;
+    uint64_t m_vertexCount;
+    uint64_t m_textureBinds;
+    std::vector<uint64_t> m_frameTimes;
+    std::chrono::steady_clock::time_point m_frameStart;
+    mutable std::vector<uint64_t> m_sorted;
+};
+
+#endif // HEADLESSTARGET_INCLUDE
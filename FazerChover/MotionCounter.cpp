@@ -0,0 +1,192 @@
+//============================================================================
+// Name        : MotionCounter.cpp
+// Description : fused depth conversion + frame difference + changed pixel count
+//============================================================================
+
+#include "MotionCounter.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+// MotionCounterAVX2.cpp, built with -mavx2
+bool isMotionKernelAVX2Built();
+std::size_t countMotionPixelsAVX2(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count);
+
+namespace
+{
+    const float DepthScale = static_cast<float>(255.0 / 2024.0);
+
+    typedef std::size_t (*CountFunction)(const uint16_t*, const uint8_t*, uint8_t*, std::size_t);
+
+    struct DepthTable
+    {
+        uint8_t value[2048];
+
+        // same float math and rounding as convertTo's saturate_cast
+        DepthTable()
+        {
+            for (int i = 0; i < 2048; i++) {
+                long v = std::lrint(i * DepthScale);
+                value[i] = static_cast<uint8_t>(v > 255 ? 255 : v);
+            }
+        }
+    };
+
+    const DepthTable& getDepthTable()
+    {
+        static DepthTable table;
+        return table;
+    }
+
+    std::size_t countScalar(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count)
+    {
+        const uint8_t* table = getDepthTable().value;
+        std::size_t changed = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            current[i] = depth[i] < 2048 ? table[depth[i]] : 255;
+            if (previous)
+                changed += current[i] != previous[i];
+        }
+        return changed;
+    }
+
+#if defined(__SSE2__)
+    inline __m128i convertSSE2(__m128i lo, __m128i hi, __m128 scale)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+        __m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+        __m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+        return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+    }
+
+    std::size_t countSSE2(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(DepthScale);
+        const __m128i zero = _mm_setzero_si128();
+        std::size_t vectorCount = count & ~static_cast<std::size_t>(15);
+        std::size_t same = 0;
+        std::size_t i = 0;
+
+        while (i < vectorCount) {
+            // per byte counters of equal pixels, folded before they can wrap
+            __m128i equal = zero;
+            std::size_t end = i + 255 * 16 < vectorCount ? i + 255 * 16 : vectorCount;
+            for (; i < end; i += 16) {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + i));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + i + 8));
+                __m128i value = convertSSE2(lo, hi, scale);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(current + i), value);
+                if (previous) {
+                    __m128i old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + i));
+                    equal = _mm_sub_epi8(equal, _mm_cmpeq_epi8(value, old));
+                }
+            }
+            __m128i sums = _mm_sad_epu8(equal, zero);
+            same += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+        }
+
+        std::size_t changed = previous ? vectorCount - same : 0;
+        return changed + countScalar(depth + i, previous ? previous + i : NULL, current + i, count - i);
+    }
+#endif
+
+    bool hasAVX2()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        unsigned int eax, ebx, ecx, edx;
+        __cpuid(0, eax, ebx, ecx, edx);
+        if (eax < 7)
+            return false;
+        __cpuid(1, eax, ebx, ecx, edx);
+        const unsigned int osxsave = 1u << 27, avx = 1u << 28;
+        if ((ecx & osxsave) == 0 || (ecx & avx) == 0)
+            return false;
+        // the os must save the ymm registers
+        unsigned int xcr0, xcr0High;
+        __asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+        if ((xcr0 & 6) != 6)
+            return false;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        return (ebx & (1u << 5)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    bool isSupported(MotionKernel kernel)
+    {
+        switch (kernel) {
+            case MotionKernelScalar:
+                return true;
+            case MotionKernelSSE2:
+#if defined(__SSE2__)
+                return true;
+#else
+                return false;
+#endif
+            case MotionKernelAVX2:
+                return isMotionKernelAVX2Built() && hasAVX2();
+        }
+        return false;
+    }
+
+    CountFunction getFunction(MotionKernel kernel)
+    {
+        switch (kernel) {
+#if defined(__SSE2__)
+            case MotionKernelSSE2:
+                return countSSE2;
+#endif
+            case MotionKernelAVX2:
+                return countMotionPixelsAVX2;
+            default:
+                return countScalar;
+        }
+    }
+
+    MotionKernel& selectedKernel()
+    {
+        static MotionKernel kernel = isSupported(MotionKernelAVX2) ? MotionKernelAVX2 : isSupported(MotionKernelSSE2) ? MotionKernelSSE2 : MotionKernelScalar;
+        return kernel;
+    }
+
+    CountFunction& selectedFunction()
+    {
+        static CountFunction function = getFunction(selectedKernel());
+        return function;
+    }
+}
+
+std::size_t countMotionPixels(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count)
+{
+    return selectedFunction()(depth, previous, current, count);
+}
+
+MotionKernel getMotionKernel()
+{
+    return selectedKernel();
+}
+
+bool setMotionKernel(MotionKernel kernel)
+{
+    if (!isSupported(kernel))
+        return false;
+    selectedKernel() = kernel;
+    selectedFunction() = getFunction(kernel);
+    return true;
+}
+
+// tail handling for the AVX2 kernel
+std::size_t countMotionPixelsTail(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count)
+{
+    return countScalar(depth, previous, current, count);
+}
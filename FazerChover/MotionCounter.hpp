@@ -0,0 +1,32 @@
+//============================================================================
+// Name        : MotionCounter.hpp
+// Description : fused depth conversion + frame difference + changed pixel count
+//============================================================================
+
+#ifndef MOTIONCOUNTER_INCLUDE
+#define MOTIONCOUNTER_INCLUDE
+
+#include <cstddef>
+#include <stdint.h>
+
+enum MotionKernel
+{
+    MotionKernelScalar,
+    MotionKernelSSE2,
+    MotionKernelAVX2
+};
+
+// Converts count depth values to 8 bit exactly like
+// depth.convertTo(current, CV_8UC1, 255.0 / 2024.0), and returns how many of
+// them differ from previous, i.e. the non zero pixels of
+// absdiff(previous, current). One pass, nothing allocated.
+// previous may be NULL for the first frame, then 0 is returned.
+std::size_t countMotionPixels(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count);
+
+// the fastest kernel the cpu supports is picked on first use
+MotionKernel getMotionKernel();
+
+// false if the cpu (or the build) does not support kernel
+bool setMotionKernel(MotionKernel kernel);
+
+#endif // MOTIONCOUNTER_INCLUDE
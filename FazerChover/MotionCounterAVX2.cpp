@@ -0,0 +1,74 @@
+//============================================================================
+// Name        : MotionCounterAVX2.cpp
+// Description : AVX2 kernel for countMotionPixels, built with -mavx2
+//============================================================================
+
+#include "MotionCounter.hpp"
+
+#if defined(__AVX2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+std::size_t countMotionPixelsTail(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count);
+
+#if defined(__AVX2__) && defined(__x86_64__)
+
+bool isMotionKernelAVX2Built()
+{
+    return true;
+}
+
+namespace
+{
+    inline __m256i convertAVX2(const uint16_t* depth, __m256 scale)
+    {
+        __m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(depth)))), scale));
+        __m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + 8)))), scale));
+        __m256i c = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + 16)))), scale));
+        __m256i d = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + 24)))), scale));
+        // packs work per 128 bit lane, the permute restores pixel order
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+        return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    }
+}
+
+std::size_t countMotionPixelsAVX2(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(static_cast<float>(255.0 / 2024.0));
+    const __m256i zero = _mm256_setzero_si256();
+    std::size_t vectorCount = count & ~static_cast<std::size_t>(31);
+    std::size_t same = 0;
+    std::size_t i = 0;
+
+    while (i < vectorCount) {
+        __m256i equal = zero;
+        std::size_t end = i + 255 * 32 < vectorCount ? i + 255 * 32 : vectorCount;
+        for (; i < end; i += 32) {
+            __m256i value = convertAVX2(depth + i, scale);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(current + i), value);
+            if (previous) {
+                __m256i old = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous + i));
+                equal = _mm256_sub_epi8(equal, _mm256_cmpeq_epi8(value, old));
+            }
+        }
+        __m256i sums = _mm256_sad_epu8(equal, zero);
+        same += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) + _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+    }
+
+    std::size_t changed = previous ? vectorCount - same : 0;
+    return changed + countMotionPixelsTail(depth + i, previous ? previous + i : NULL, current + i, count - i);
+}
+
+#else
+
+bool isMotionKernelAVX2Built()
+{
+    return false;
+}
+
+std::size_t countMotionPixelsAVX2(const uint16_t* depth, const uint8_t* previous, uint8_t* current, std::size_t count)
+{
+    return countMotionPixelsTail(depth, previous, current, count);
+}
+
+#endif
@@ -0,0 +1,118 @@
+//============================================================================
+// Name        : MotionDetector.cpp
+// Description : raw depth frame in, motion metrics out, no per frame allocation
+//============================================================================
+
+#include "MotionDetector.hpp"
+
+#include <algorithm>
+
+#include "Trace.hpp"
+
+MotionDetector::MotionDetector(int width, int height) :
+m_width(width), m_height(height), m_decimation(1), m_pooling(DepthPoolingMin), m_rowBuffer(2 * width), m_filter(width, height), m_zones(width, height), m_background(width * height), m_areaCount(0), m_current(width * height), m_previous(width * height)
+{
+    m_zones.setBackgroundModel(&m_background);
+}
+
+void MotionDetector::setDecimation(int factor, DepthPooling pooling)
+{
+    m_decimation = factor >= 4 ? 4 : factor >= 2 ? 2 : 1;
+    m_pooling = pooling;
+    int width = getWidth();
+    int height = getHeight();
+    bool isSubtracting = m_zones.getBackgroundModel() != NULL;
+    
+    m_decimated.assign(m_decimation > 1 ? width * height : 0, 0);
+    m_filter = DepthFilter(width, height, m_filter.getLength());
+    ZonedMotion zones(width, height, m_zones.getColumns(), m_zones.getRows());
+    m_zones = zones;
+    m_background = BackgroundModel(width * height);
+    m_zones.setBackgroundModel(isSubtracting ? &m_background : NULL);
+    m_current.assign(width * height, 0);
+    m_previous.assign(width * height, 0);
+}
+
+int MotionDetector::getDecimation() const
+{
+    return m_decimation;
+}
+
+DepthFilter& MotionDetector::getFilter()
+{
+    return m_filter;
+}
+
+ZonedMotion& MotionDetector::getZones()
+{
+    return m_zones;
+}
+
+BackgroundModel& MotionDetector::getBackground()
+{
+    return m_background;
+}
+
+void MotionDetector::setBackgroundSubtraction(bool enabled)
+{
+    m_zones.setBackgroundModel(enabled ? &m_background : NULL);
+}
+
+int MotionDetector::addArea(double left, double top, double width, double height)
+{
+    if (m_areaCount >= MotionSample::MaxAreas)
+        return -1;
+    // whatever lies outside the frame is cut off here, not silently later
+    double right = std::min(1.0, left + width);
+    double bottom = std::min(1.0, top + height);
+    left = std::max(0.0, left);
+    top = std::max(0.0, top);
+    Area area = {left, top, std::max(0.0, right - left), std::max(0.0, bottom - top)};
+    m_areas[m_areaCount] = area;
+    return m_areaCount++;
+}
+
+void MotionDetector::process(const uint16_t* depth, MotionSample& sample)
+{
+    if (m_decimation > 1) {
+        TRACE_SCOPE("decimate");
+        decimateDepth(depth, m_width, m_height, m_decimation, m_pooling, &m_decimated[0], &m_rowBuffer[0]);
+        depth = &m_decimated[0];
+    }
+    {
+        TRACE_SCOPE("depth filter");
+        depth = m_filter.apply(depth);
+    }
+    m_current.swap(m_previous);
+    {
+        // conversion, difference and count are one pass
+        TRACE_SCOPE("zoned motion");
+        sample.changedPixels = m_zones.process(depth, &m_previous[0], &m_current[0]);
+    }
+    {
+        TRACE_SCOPE("area activity");
+        sample.activity = m_zones.getActivity();
+        for (int i = 0; i < m_areaCount; i++)
+            sample.areaActivity[i] = m_zones.getActivity(m_areas[i].left, m_areas[i].top, m_areas[i].width, m_areas[i].height);
+    }
+}
+
+int MotionDetector::getWidth() const
+{
+    return m_width / m_decimation;
+}
+
+int MotionDetector::getHeight() const
+{
+    return m_height / m_decimation;
+}
+
+const uint8_t* MotionDetector::getCurrent() const
+{
+    return &m_current[0];
+}
+
+const uint8_t* MotionDetector::getPrevious() const
+{
+    return &m_previous[0];
+}
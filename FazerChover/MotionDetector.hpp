@@ -0,0 +1,87 @@
+//============================================================================
+// Name        : MotionDetector.hpp
+// Description : raw depth frame in, motion metrics out, no per frame allocation
+//============================================================================
+
+#ifndef MOTIONDETECTOR_INCLUDE
+#define MOTIONDETECTOR_INCLUDE
+
+#include <chrono>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include "BackgroundModel.hpp"
+#include "DepthDecimation.hpp"
+#include "DepthFilter.hpp"
+#include "ZonedMotion.hpp"
+
+struct MotionSample
+{
+    static const int MaxAreas = 8;
+    
+    std::size_t changedPixels;       // foreground, or changed without background model, in detection pixels
+    double activity;                 // foreground fraction of the active tiles
+    double areaActivity[MaxAreas];   // per area added with addArea
+    std::chrono::steady_clock::time_point time; // when the depth frame was taken
+};
+
+// The whole detection pipeline on one frame: optional decimation, depth
+// filter, then the zoned count against the background model (or the previous
+// frame). Every buffer is allocated by the setup calls; process only swaps
+// the two 8 bit frames, so a steady stream of frames allocates nothing (see
+// AllocationCounter).
+class MotionDetector
+{
+public:
+    explicit MotionDetector(int width = 640, int height = 480);
+    
+    // setup; decimation first, it resizes the filter, zones and background
+    // model. Detection runs on (width / factor) x (height / factor) pooled
+    // depth, activities stay fractions of the frame
+    void setDecimation(int factor, DepthPooling pooling = DepthPoolingMin);
+    int getDecimation() const;
+    DepthFilter& getFilter();
+    ZonedMotion& getZones();
+    BackgroundModel& getBackground();
+    // on by default; off compares consecutive frames
+    void setBackgroundSubtraction(bool enabled);
+    // in 0..1 frame coordinates, clipped to the frame; -1 when MaxAreas
+    // are taken
+    int addArea(double left, double top, double width, double height);
+    
+    // depth is the width x height CV_16UC1 frame; fills every field of
+    // sample but time
+    void process(const uint16_t* depth, MotionSample& sample);
+    
+    // detection size
+    int getWidth() const;
+    int getHeight() const;
+    // 8 bit frames of the last two process calls, foreground masks with the
+    // background model
+    const uint8_t* getCurrent() const;
+    const uint8_t* getPrevious() const;
+    
+private:
+    struct Area
+    {
+        double left, top, width, height;
+    };
+    
+    int m_width;
+    int m_height;
+    int m_decimation;
+    DepthPooling m_pooling;
+    std::vector<uint16_t> m_decimated;
+    std::vector<uint16_t> m_rowBuffer;
+    DepthFilter m_filter;
+    ZonedMotion m_zones;
+    BackgroundModel m_background;
+    Area m_areas[MotionSample::MaxAreas];
+    int m_areaCount;
+    // ping-pong, swapped every frame
+    std::vector<uint8_t> m_current;
+    std::vector<uint8_t> m_previous;
+};
+
+#endif // MOTIONDETECTOR_INCLUDE
@@ -0,0 +1,163 @@
+//============================================================================
+// Name        : MyFreenectDevice.hpp
+// Description : libfreenect device feeding depth/rgb through triple buffers
+//============================================================================
+
+#ifndef MYFREENECTDEVICE_INCLUDE
+#define MYFREENECTDEVICE_INCLUDE
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+
+#include "libfreenect/libfreenect.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include "FrameSource.hpp"
+#include "TripleBuffer.hpp"
+#include "DepthRecording.hpp"
+
+class MyFreenectDevice: public Freenect::FreenectDevice, public FrameSource
+{
+public:
+    MyFreenectDevice(freenect_context *_ctx, int _index) :
+    Freenect::FreenectDevice(_ctx, _index), ownMat(cv::Size(640, 480), CV_8UC3, cv::Scalar(0)), m_recorder(NULL), m_videoSubscribers(0), m_videoWarmup(0)
+    {
+        
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            m_depthFrames.getSlot(i).create(cv::Size(640, 480), CV_16UC1);
+            m_rgbFrames.getSlot(i).create(cv::Size(640, 480), CV_8UC3);
+        }
+    }
+    
+    // auto exposure needs a few frames, about half a second at 30Hz
+    static const int VideoWarmupFrames = 15;
+    
+    void start()
+    {
+        setDepthBuffer();
+        startDepth();
+    }
+    
+    void stop()
+    {
+        if (m_videoSubscribers > 0)
+            stopVideo();
+        m_videoSubscribers = 0;
+        stopDepth();
+    }
+    
+    void subscribeVideo()
+    {
+        if (m_videoSubscribers++ == 0) {
+            m_videoWarmup = VideoWarmupFrames;
+            setVideoBuffer();
+            startVideo();
+        }
+    }
+    
+    void unsubscribeVideo()
+    {
+        if (m_videoSubscribers > 0 && --m_videoSubscribers == 0)
+            stopVideo();
+    }
+    
+    // every depth frame, and video while subscribed, is also handed to
+    // recorder (NULL to stop), which copies it and writes it on its own thread. Detach only after stop, so
+    // no callback still holds the recorder when it closes
+    void setRecorder(DepthRecorder* recorder)
+    {
+        m_recorder = recorder;
+    }
+    
+    // Do not call directly even in child. libfreenect wrote the frame
+    // straight into the back slot, publishing it hands it over without a copy
+    void VideoCallback(void* _rgb, uint32_t timestamp)
+    {
+        // left in the back slot to be overwritten while the camera settles
+        if (m_videoWarmup > 0) {
+            m_videoWarmup--;
+            return;
+        }
+        cv::Mat& slot = m_rgbFrames.getBackBuffer();
+        // only when libfreenect did not take the slot as its buffer
+        if (_rgb != slot.data)
+            std::memcpy(slot.data, _rgb, slot.total() * slot.elemSize());
+        // kept for the next depth frame, raw recordings only
+        DepthRecorder* recorder = m_recorder;
+        if (recorder)
+            recorder->addVideo(slot.data);
+        m_rgbFrames.publish();
+        setVideoBuffer();
+    }
+    ;
+    
+    // Do not call directly even in child. As VideoCallback
+    void DepthCallback(void* _depth, uint32_t timestamp)
+    {
+        cv::Mat& slot = m_depthFrames.getBackBuffer();
+        if (_depth != slot.data)
+            std::memcpy(slot.data, _depth, slot.total() * slot.elemSize());
+        DepthRecorder* recorder = m_recorder;
+        if (recorder) {
+            std::chrono::microseconds now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch());
+            recorder->addFrame(reinterpret_cast<const uint16_t*>(slot.data), now.count());
+        }
+        m_depthFrames.publish();
+        setDepthBuffer();
+    }
+    
+    bool getVideo(cv::Mat& output)
+    {
+        if (!m_rgbFrames.claim())
+            return false;
+        cv::cvtColor(m_rgbFrames.getFrontBuffer(), output, CV_RGB2BGR);
+        return true;
+    }
+    
+    // output views the claimed frame (no copy or conversion); it stays valid
+    // until the next getVideo or getVideoRgb
+    bool getVideoRgb(cv::Mat& output)
+    {
+        if (!m_rgbFrames.claim())
+            return false;
+        output = m_rgbFrames.getFrontBuffer();
+        return true;
+    }
+    
+    // output views the claimed frame (no copy); it stays valid until the next getDepth
+    bool getDepth(cv::Mat& output)
+    {
+        if (!m_depthFrames.claim())
+            return false;
+        output = m_depthFrames.getFrontBuffer();
+        return true;
+    }
+private:
+    // libfreenect fills the next frame into the back slot. Called before
+    // the stream starts and, from the callback, after every publish hands
+    // the producer a new back slot, as libfreenect's own glview example does
+    void setDepthBuffer()
+    {
+        freenect_set_depth_buffer(const_cast<freenect_device*>(getDevice()), m_depthFrames.getBackBuffer().data);
+    }
+    
+    void setVideoBuffer()
+    {
+        freenect_set_video_buffer(const_cast<freenect_device*>(getDevice()), m_rgbFrames.getBackBuffer().data);
+    }
+    
+    cv::Mat ownMat;
+    
+    TripleBuffer<cv::Mat> m_depthFrames;
+    TripleBuffer<cv::Mat> m_rgbFrames;
+    std::atomic<DepthRecorder*> m_recorder;
+    int m_videoSubscribers; // render thread only
+    std::atomic<int> m_videoWarmup;
+};
+
+#endif // MYFREENECTDEVICE_INCLUDE
@@ -0,0 +1,16 @@
+//============================================================================
+// Name        : PixelOrder.hpp
+// Description : channel order of 3 byte per pixel camera frames
+//============================================================================
+
+#ifndef PIXELORDER_INCLUDE
+#define PIXELORDER_INCLUDE
+
+// libfreenect delivers RGB, OpenCV's imencode and imshow expect BGR
+enum PixelOrder
+{
+    PixelOrderRgb,
+    PixelOrderBgr
+};
+
+#endif // PIXELORDER_INCLUDE
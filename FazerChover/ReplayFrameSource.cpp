@@ -0,0 +1,243 @@
+//============================================================================
+// Name        : ReplayFrameSource.cpp
+// Description : plays back a recorded depth/rgb session in place of the Kinect
+//============================================================================
+
+#include "ReplayFrameSource.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace
+{
+    const char RawMagic[8] = "FCRAW01";
+    const std::size_t HeaderSize = 16;
+    const std::size_t RecordHeaderSize = 16;
+    // the only size FrameSource hands out, consumers copy and read that much
+    const std::size_t FrameWidth = 640;
+    const std::size_t FrameHeight = 480;
+    
+    template <typename T>
+    T readValue(const unsigned char* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+}
+
+ReplayFrameSource::ReplayFrameSource() :
+m_isCompressed(false), m_data(NULL), m_size(0), m_width(0), m_height(0), m_recordSize(0), m_frameCount(0), m_pacing(RealTime), m_isLooped(true), m_isRunning(false), m_nextFrame(0), m_currentFrame(0), m_videoFrame(0), m_videoSubscribers(0)
+{
+    
+}
+
+ReplayFrameSource::~ReplayFrameSource()
+{
+    close();
+}
+
+bool ReplayFrameSource::openFromFile(const std::string& path, Pacing pacing)
+{
+    close();
+    
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < HeaderSize) {
+        ::close(fd);
+        return false;
+    }
+    
+    void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    
+    m_data = static_cast<const unsigned char*>(data);
+    m_size = info.st_size;
+    
+    m_isCompressed = DepthRecording::isRecording(m_data, m_size);
+    if (!m_isCompressed && std::memcmp(m_data, RawMagic, sizeof(RawMagic)) != 0) {
+        close();
+        return false;
+    }
+    // both layouts keep uint32 width and height at 8 and 12, checked before
+    // the recording sizes anything by them
+    if (readValue<uint32_t>(m_data + 8) != FrameWidth || readValue<uint32_t>(m_data + 12) != FrameHeight) {
+        close();
+        return false;
+    }
+    m_width = static_cast<int>(FrameWidth);
+    m_height = static_cast<int>(FrameHeight);
+    
+    if (m_isCompressed) {
+        if (!m_recording.openFromMemory(m_data, m_size)) {
+            close();
+            return false;
+        }
+        m_frameCount = m_recording.getFrameCount();
+    } else {
+        m_recordSize = RecordHeaderSize + FrameWidth * FrameHeight * (sizeof(uint16_t) + 3);
+        m_frameCount = m_size >= HeaderSize + m_recordSize ? (m_size - HeaderSize) / m_recordSize : 0;
+    }
+    
+    if (m_frameCount == 0) {
+        close();
+        return false;
+    }
+    
+    // frames are read front to back
+    madvise(const_cast<unsigned char*>(m_data), m_size, MADV_SEQUENTIAL);
+    
+    m_pacing = pacing;
+    m_nextFrame = 0;
+    m_currentFrame = 0;
+    m_videoFrame = m_frameCount;
+    return true;
+}
+
+void ReplayFrameSource::close()
+{
+    if (m_data)
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    m_data = NULL;
+    m_size = 0;
+    m_frameCount = 0;
+    m_isRunning = false;
+}
+
+void ReplayFrameSource::setLooped(bool looped)
+{
+    m_isLooped = looped;
+}
+
+bool ReplayFrameSource::isLooped() const
+{
+    return m_isLooped;
+}
+
+bool ReplayFrameSource::isFinished() const
+{
+    return !m_isLooped && m_nextFrame >= m_frameCount;
+}
+
+std::size_t ReplayFrameSource::getFrameCount() const
+{
+    return m_frameCount;
+}
+
+void ReplayFrameSource::start()
+{
+    m_isRunning = m_data != NULL;
+    m_nextFrame = 0;
+    m_videoFrame = m_frameCount;
+    m_startTime = std::chrono::steady_clock::now();
+}
+
+void ReplayFrameSource::stop()
+{
+    m_isRunning = false;
+}
+
+const unsigned char* ReplayFrameSource::getRecord(std::size_t n) const
+{
+    return m_data + HeaderSize + n * m_recordSize;
+}
+
+uint64_t ReplayFrameSource::getTimestamp(std::size_t n) const
+{
+    if (m_isCompressed)
+        return m_recording.getTimestamp(n);
+    return readValue<uint64_t>(getRecord(n));
+}
+
+uint32_t ReplayFrameSource::getFlags(std::size_t n) const
+{
+    if (m_isCompressed)
+        return HasDepth;
+    return readValue<uint32_t>(getRecord(n) + 8);
+}
+
+bool ReplayFrameSource::getDepth(cv::Mat& output)
+{
+    if (!m_isRunning)
+        return false;
+    
+    if (m_nextFrame >= m_frameCount) {
+        if (!m_isLooped)
+            return false;
+        m_nextFrame = 0;
+        m_startTime = std::chrono::steady_clock::now();
+    }
+    
+    std::size_t frame = m_nextFrame;
+    if (m_pacing == RealTime) {
+        // skip to the newest frame whose time has come, like the live device would
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_startTime).count();
+        uint64_t first = getTimestamp(0);
+        if (getTimestamp(frame) - first > elapsed)
+            return false;
+        while (frame + 1 < m_frameCount && getTimestamp(frame + 1) - first <= elapsed)
+            frame++;
+    }
+    m_nextFrame = frame + 1;
+    m_currentFrame = frame;
+    
+    if ((getFlags(frame) & HasDepth) == 0)
+        return false;
+    
+    if (m_isCompressed) {
+        const uint16_t* depth = m_recording.decodeFrame(frame);
+        if (!depth)
+            return false;
+        output = cv::Mat(m_height, m_width, CV_16UC1, const_cast<uint16_t*>(depth));
+        return true;
+    }
+    
+    unsigned char* depth = const_cast<unsigned char*>(getRecord(frame) + RecordHeaderSize);
+    output = cv::Mat(m_height, m_width, CV_16UC1, depth);
+    return true;
+}
+
+bool ReplayFrameSource::getVideo(cv::Mat& output)
+{
+    cv::Mat rgb;
+    if (!getVideoRgb(rgb))
+        return false;
+    cv::cvtColor(rgb, output, CV_RGB2BGR);
+    return true;
+}
+
+void ReplayFrameSource::subscribeVideo()
+{
+    m_videoSubscribers++;
+}
+
+void ReplayFrameSource::unsubscribeVideo()
+{
+    if (m_videoSubscribers > 0)
+        m_videoSubscribers--;
+}
+
+bool ReplayFrameSource::getVideoRgb(cv::Mat& output)
+{
+    // recorded frames need no warm up, but are only handed out like live ones.
+    // The detection thread moves the current frame on, read it once so the
+    // checks and the record are about the same one
+    std::size_t frame = m_currentFrame;
+    if (!m_isRunning || m_videoSubscribers == 0 || m_videoFrame == frame || (getFlags(frame) & HasVideo) == 0)
+        return false;
+    
+    m_videoFrame = frame;
+    unsigned char* rgb = const_cast<unsigned char*>(getRecord(frame) + RecordHeaderSize + m_width * m_height * sizeof(uint16_t));
+    output = cv::Mat(m_height, m_width, CV_8UC3, rgb);
+    return true;
+}
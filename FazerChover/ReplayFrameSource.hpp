@@ -0,0 +1,88 @@
+//============================================================================
+// Name        : ReplayFrameSource.hpp
+// Description : plays back a recorded depth/rgb session in place of the Kinect
+//============================================================================
+
+#ifndef REPLAYFRAMESOURCE_INCLUDE
+#define REPLAYFRAMESOURCE_INCLUDE
+
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <stdint.h>
+
+#include "FrameSource.hpp"
+#include "DepthRecording.hpp"
+
+// Recording layout, all little endian:
+//   header  : char magic[8] = "FCRAW01", uint32 width, uint32 height
+//   records : uint64 timestamp (microseconds), uint32 flags, uint32 reserved,
+//             uint16 depth[width*height], uint8 rgb[width*height*3]
+// Records have a fixed size so frame n is found without scanning. They are
+// written by DepthRecorder in its Raw format (--record-raw). The file is
+// memory mapped and depth frames are handed out without copying.
+// Compressed depth only recordings (see DepthRecording) are played as well;
+// their frames are decoded into one buffer and carry no video. Either kind
+// must be 640x480, the size FrameSource hands out; openFromFile rejects
+// anything else.
+class ReplayFrameSource : public FrameSource
+{
+public:
+    enum Pacing
+    {
+        RealTime, // follow the recorded timestamps
+        MaxSpeed  // one new frame per getDepth call
+    };
+    
+    enum RecordFlags
+    {
+        HasDepth = 1,
+        HasVideo = 2
+    };
+    
+    ReplayFrameSource();
+    ~ReplayFrameSource();
+    
+    bool openFromFile(const std::string& path, Pacing pacing = RealTime);
+    void close();
+    
+    void setLooped(bool looped);
+    bool isLooped() const;
+    bool isFinished() const;
+    std::size_t getFrameCount() const;
+    
+    void start();
+    void stop();
+    void subscribeVideo();
+    void unsubscribeVideo();
+    bool getVideo(cv::Mat& output);
+    bool getVideoRgb(cv::Mat& output);
+    bool getDepth(cv::Mat& output);
+    
+private:
+    ReplayFrameSource(const ReplayFrameSource&);
+    ReplayFrameSource& operator=(const ReplayFrameSource&);
+    
+    const unsigned char* getRecord(std::size_t n) const;
+    uint64_t getTimestamp(std::size_t n) const;
+    uint32_t getFlags(std::size_t n) const;
+    
+    DepthRecording m_recording;
+    bool m_isCompressed;
+    const unsigned char* m_data;
+    std::size_t m_size;
+    int m_width;
+    int m_height;
+    std::size_t m_recordSize;
+    std::size_t m_frameCount;
+    Pacing m_pacing;
+    bool m_isLooped;
+    std::atomic<bool> m_isRunning; // read by the detection and render threads
+    std::size_t m_nextFrame;
+    std::atomic<std::size_t> m_currentFrame; // written by getDepth, read by getVideo
+    std::size_t m_videoFrame;
+    int m_videoSubscribers;
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+#endif // REPLAYFRAMESOURCE_INCLUDE
@@ -0,0 +1,89 @@
+//============================================================================
+// Name        : ResourcePath.cpp
+// Description : resourcePath() where there is no bundle, e.g. linux
+//============================================================================
+
+#include "ResourcePath.hpp"
+
+// the bundle version lives in ResourcePath.mm
+#ifndef __APPLE__
+
+#include <cstdlib>
+#include <vector>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // a folder holds the resources when it has the pack or the animations
+    bool hasResources(const std::string& directory)
+    {
+        struct stat info;
+        return stat((directory + "assets.pack").c_str(), &info) == 0
+            || stat((directory + "animations.xml").c_str(), &info) == 0;
+    }
+
+    std::string executableDirectory()
+    {
+        char path[PATH_MAX];
+        ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+        if (length <= 0)
+            return std::string();
+        std::string executable(path, length);
+        return executable.substr(0, executable.find_last_of('/') + 1);
+    }
+
+    std::string findResources()
+    {
+        std::vector<std::string> candidates;
+
+        const char* variable = std::getenv("FAZERCHOVER_DATA");
+        if (variable && *variable)
+            candidates.push_back(std::string(variable) + "/");
+
+        // next to the executable, as the build leaves it, or an installed prefix
+        std::string executable = executableDirectory();
+        if (!executable.empty())
+        {
+            candidates.push_back(executable);
+            candidates.push_back(executable + "resources/");
+            candidates.push_back(executable + "../share/fazerchover/");
+        }
+
+        variable = std::getenv("XDG_DATA_HOME");
+        if (variable && *variable)
+            candidates.push_back(std::string(variable) + "/fazerchover/");
+        else if ((variable = std::getenv("HOME")) && *variable)
+            candidates.push_back(std::string(variable) + "/.local/share/fazerchover/");
+
+        variable = std::getenv("XDG_DATA_DIRS");
+        std::string dataDirs = variable && *variable ? variable : "/usr/local/share:/usr/share";
+        std::string::size_type begin = 0;
+        while (begin <= dataDirs.size())
+        {
+            std::string::size_type end = dataDirs.find(':', begin);
+            if (end == std::string::npos)
+                end = dataDirs.size();
+            if (end > begin)
+                candidates.push_back(dataDirs.substr(begin, end - begin) + "/fazerchover/");
+            begin = end + 1;
+        }
+
+        for (std::size_t i = 0; i < candidates.size(); ++i)
+        {
+            if (hasResources(candidates[i]))
+                return candidates[i];
+        }
+        return std::string();
+    }
+}
+
+////////////////////////////////////////////////////////////
+std::string resourcePath(void)
+{
+    static const std::string path = findResources();
+    return path;
+}
+
+#endif
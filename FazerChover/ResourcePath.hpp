@@ -37,6 +37,12 @@
 /// \return The path to the resource folder associate
 /// with the main bundle or an empty string is there is no bundle.
 ///
+/// Without a bundle (ResourcePath.cpp) the first folder holding
+/// assets.pack or animations.xml is used, searching in order
+/// $FAZERCHOVER_DATA, the executable's folder, its resources/ and
+/// ../share/fazerchover/, then fazerchover/ under the XDG data
+/// folders.
+///
 ////////////////////////////////////////////////////////////
 std::string resourcePath(void);
 
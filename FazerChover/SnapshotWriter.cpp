@@ -0,0 +1,159 @@
+//============================================================================
+// Name        : SnapshotWriter.cpp
+// Description : encodes and writes snapshots on a background thread
+//============================================================================
+
+#include "SnapshotWriter.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "Trace.hpp"
+
+SnapshotWriter::SnapshotWriter(std::size_t capacity, int width, int height) :
+m_slots(capacity), m_jobs(capacity), m_free(capacity), m_format(Jpeg), m_level(90), m_droppedFrames(0), m_writtenFrames(0), m_isRunning(false)
+{
+    for (std::size_t i = 0; i < capacity; i++) {
+        m_slots[i].create(height, width, CV_8UC3);
+        m_free.tryPush(i);
+    }
+    m_converted.create(height, width, CV_8UC3);
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    stop();
+}
+
+void SnapshotWriter::setFormat(Format format, int level)
+{
+    m_format = format;
+    m_level = level;
+}
+
+void SnapshotWriter::start()
+{
+    if (m_isRunning)
+        return;
+    m_isRunning = true;
+    m_thread = std::thread(&SnapshotWriter::run, this);
+}
+
+void SnapshotWriter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_isRunning = false;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+bool SnapshotWriter::submit(const cv::Mat& frame, PixelOrder order, const std::string& path)
+{
+    // copyTo would reallocate a slot for any other size
+    const cv::Mat& first = m_slots[0];
+    if (frame.rows != first.rows || frame.cols != first.cols || frame.type() != first.type()) {
+        std::cout << "fail snapshot: " << frame.cols << "x" << frame.rows << " frame" << std::endl;
+        return false;
+    }
+    Job job;
+    if (!m_free.tryPop(job.slot)) {
+        m_droppedFrames++;
+        return false;
+    }
+    frame.copyTo(m_slots[job.slot]);
+    job.order = order;
+    job.path = path;
+    // cannot fail: there are as many queue entries as slots
+    m_jobs.tryPush(job);
+    // no lock taken here: the worker also wakes up on its own timeout
+    m_wake.notify_one();
+    return true;
+}
+
+void SnapshotWriter::run()
+{
+    Trace::setThreadName("snapshots");
+    Job job;
+    while (true) {
+        if (m_jobs.tryPop(job)) {
+            write(job);
+            m_free.tryPush(job.slot);
+            continue;
+        }
+        if (!m_isRunning)
+            break;
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wake.wait_for(lock, std::chrono::milliseconds(100));
+    }
+}
+
+void SnapshotWriter::write(Job& job)
+{
+    TRACE_SCOPE("snapshot");
+    std::vector<int> params;
+    std::string extension;
+    if (m_format == Png) {
+        extension = ".png";
+        params.push_back(CV_IMWRITE_PNG_COMPRESSION);
+    } else {
+        extension = ".jpg";
+        params.push_back(CV_IMWRITE_JPEG_QUALITY);
+    }
+    params.push_back(m_level);
+    
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const cv::Mat* frame = &m_slots[job.slot];
+    if (job.order == PixelOrderRgb) {
+        cv::cvtColor(*frame, m_converted, CV_RGB2BGR);
+        frame = &m_converted;
+    }
+    if (!cv::imencode(extension, *frame, m_buffer, params)) {
+        std::cout << "fail encode snapshot " << job.path << std::endl;
+        return;
+    }
+    std::chrono::steady_clock::time_point encoded = std::chrono::steady_clock::now();
+    m_encodeLatency.add(encoded - begin);
+    
+    std::string path = job.path + extension;
+    std::ofstream file(path.c_str(), std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&m_buffer[0]), m_buffer.size());
+    if (!file) {
+        std::cout << "fail write snapshot " << path << std::endl;
+        return;
+    }
+    file.close();
+    m_writeLatency.add(std::chrono::steady_clock::now() - encoded);
+    m_writtenFrames++;
+    std::cout << path << std::endl;
+}
+
+std::size_t SnapshotWriter::getQueueSize() const
+{
+    return m_jobs.getSize();
+}
+
+uint64_t SnapshotWriter::getDroppedFrames() const
+{
+    return m_droppedFrames;
+}
+
+uint64_t SnapshotWriter::getWrittenFrames() const
+{
+    return m_writtenFrames;
+}
+
+const StageLatency& SnapshotWriter::getEncodeLatency() const
+{
+    return m_encodeLatency;
+}
+
+const StageLatency& SnapshotWriter::getWriteLatency() const
+{
+    return m_writeLatency;
+}
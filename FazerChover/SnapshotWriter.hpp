@@ -0,0 +1,90 @@
+//============================================================================
+// Name        : SnapshotWriter.hpp
+// Description : encodes and writes snapshots on a background thread
+//============================================================================
+
+#ifndef SNAPSHOTWRITER_INCLUDE
+#define SNAPSHOTWRITER_INCLUDE
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "PixelOrder.hpp"
+#include "SpscQueue.hpp"
+#include "StageLatency.hpp"
+
+// The render thread submits frames without ever waiting or allocating: the
+// frame is copied as it is into one of capacity slots preallocated at the
+// frame size, and the worker swaps the channels to BGR if needed, encodes
+// and writes it. When every slot is still queued the frame is dropped. Only
+// one thread may submit.
+class SnapshotWriter
+{
+public:
+    enum Format
+    {
+        Png,
+        Jpeg
+    };
+    
+    explicit SnapshotWriter(std::size_t capacity = 4, int width = 640, int height = 480);
+    ~SnapshotWriter();
+    
+    // level is the jpeg quality (0-100) or the png compression (0-9)
+    void setFormat(Format format, int level);
+    
+    void start();
+    
+    // writes what is still queued, then stops
+    void stop();
+    
+    // frame is width x height CV_8UC3 in order, and may be reused as soon
+    // as this returns. path gets the format's extension appended. False when
+    // dropped or of another size
+    bool submit(const cv::Mat& frame, PixelOrder order, const std::string& path);
+    
+    std::size_t getQueueSize() const;
+    uint64_t getDroppedFrames() const;
+    uint64_t getWrittenFrames() const;
+    const StageLatency& getEncodeLatency() const;
+    const StageLatency& getWriteLatency() const;
+    
+private:
+    SnapshotWriter(const SnapshotWriter&);
+    SnapshotWriter& operator=(const SnapshotWriter&);
+    
+    struct Job
+    {
+        std::size_t slot;
+        PixelOrder order;
+        std::string path;
+    };
+    
+    void run();
+    void write(Job& job);
+    
+    // slots go to the worker through m_jobs and come back through m_free
+    std::vector<cv::Mat> m_slots;
+    SpscQueue<Job> m_jobs;
+    SpscQueue<std::size_t> m_free;
+    cv::Mat m_converted; // worker only
+    std::atomic<int> m_format;
+    std::atomic<int> m_level;
+    std::vector<uchar> m_buffer;
+    StageLatency m_encodeLatency;
+    StageLatency m_writeLatency;
+    std::atomic<uint64_t> m_droppedFrames;
+    std::atomic<uint64_t> m_writtenFrames;
+    std::atomic<bool> m_isRunning;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+};
+
+#endif // SNAPSHOTWRITER_INCLUDE
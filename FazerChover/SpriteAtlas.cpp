@@ -0,0 +1,130 @@
+//============================================================================
+// Name        : SpriteAtlas.cpp
+// Description : packed sprite sheet written by tools/AtlasPacker
+//============================================================================
+
+#include "SpriteAtlas.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "AssetPack.hpp"
+
+const char SpriteAtlas::Magic[8] = "FCATL01";
+
+SpriteAtlas::SpriteAtlas()
+{
+
+}
+
+bool SpriteAtlas::loadFromFile(const std::string& path)
+{
+    if (!loadMetadataFromFile(path))
+        return false;
+
+    if (!loadResource(m_texture, m_texturePath))
+    {
+        std::cout << "fail load texture " << m_texturePath << std::endl;
+        m_records.clear();
+        m_lookup.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SpriteAtlas::loadMetadataFromFile(const std::string& path)
+{
+    m_records.clear();
+    m_lookup.clear();
+
+    std::size_t size = 0;
+    const unsigned char* packed = resourcePack().find(path, size);
+    std::vector<unsigned char> data;
+    if (!packed)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+        std::fseek(file, 0, SEEK_END);
+        long length = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        if (length > 0)
+        {
+            data.resize(length);
+            if (std::fread(&data[0], data.size(), 1, file) != 1)
+                data.clear();
+        }
+        std::fclose(file);
+        size = data.size();
+        packed = data.empty() ? NULL : &data[0];
+    }
+
+    const std::size_t headerSize = sizeof(Magic) + 2 * sizeof(uint32_t);
+    uint32_t frameCount = 0;
+    uint32_t nameLength = 0;
+    bool valid = packed && size >= headerSize
+        && std::memcmp(packed, Magic, sizeof(Magic)) == 0;
+    if (valid)
+    {
+        std::memcpy(&frameCount, packed + sizeof(Magic), sizeof(frameCount));
+        std::memcpy(&nameLength, packed + sizeof(Magic) + sizeof(frameCount), sizeof(nameLength));
+        valid = nameLength > 0 && nameLength < 1024
+            && size - headerSize >= nameLength
+            && (size - headerSize - nameLength) / sizeof(SpriteAtlasRecord) >= frameCount;
+    }
+
+    if (!valid)
+    {
+        std::cout << "fail read atlas " << path << std::endl;
+        return false;
+    }
+
+    std::string name(reinterpret_cast<const char*>(packed + headerSize), nameLength);
+    m_records.resize(frameCount);
+    if (frameCount > 0)
+        std::memcpy(&m_records[0], packed + headerSize + nameLength, frameCount * sizeof(SpriteAtlasRecord));
+
+    std::string::size_type slash = path.find_last_of('/');
+    m_texturePath = (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + name;
+
+    for (std::size_t i = 0; i < m_records.size(); ++i)
+        m_lookup[std::make_pair(m_records[i].sourceLeft, m_records[i].sourceTop)] = i;
+
+    return true;
+}
+
+const std::string& SpriteAtlas::getTexturePath() const
+{
+    return m_texturePath;
+}
+
+sf::Texture& SpriteAtlas::getTexture()
+{
+    return m_texture;
+}
+
+const sf::Texture& SpriteAtlas::getTexture() const
+{
+    return m_texture;
+}
+
+bool SpriteAtlas::findFrame(const sf::IntRect& source, sf::IntRect& rect, sf::Vector2f& offset) const
+{
+    std::map<std::pair<int, int>, std::size_t>::const_iterator it = m_lookup.find(std::make_pair(source.left, source.top));
+    if (it == m_lookup.end())
+        return false;
+
+    const SpriteAtlasRecord& record = m_records[it->second];
+    if (record.sourceWidth != source.width || record.sourceHeight != source.height)
+        return false;
+
+    rect = sf::IntRect(record.atlasLeft, record.atlasTop, record.width, record.height);
+    offset = sf::Vector2f(static_cast<float>(record.offsetX), static_cast<float>(record.offsetY));
+    return true;
+}
+
+std::size_t SpriteAtlas::getFrameCount() const
+{
+    return m_records.size();
+}
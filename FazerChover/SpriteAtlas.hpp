@@ -0,0 +1,75 @@
+//============================================================================
+// Name        : SpriteAtlas.hpp
+// Description : packed sprite sheet written by tools/AtlasPacker
+//============================================================================
+
+#ifndef SPRITEATLAS_INCLUDE
+#define SPRITEATLAS_INCLUDE
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+// File layout, all little endian:
+//   header  : char magic[8] = "FCATL01", uint32 frameCount,
+//             uint32 nameLength, char textureName[nameLength]
+//   frames  : frameCount SpriteAtlasRecord
+//
+// The texture name is relative to the directory of the metadata file. Every
+// record maps a cell of the original sheet to its trimmed copy in the atlas;
+// identical cells share one atlas rect. A fully transparent cell has an empty
+// atlas rect.
+struct SpriteAtlasRecord
+{
+    int32_t sourceLeft;
+    int32_t sourceTop;
+    int32_t sourceWidth;
+    int32_t sourceHeight;
+    int32_t atlasLeft;
+    int32_t atlasTop;
+    int32_t width;
+    int32_t height;
+    int32_t offsetX;
+    int32_t offsetY;
+};
+
+class SpriteAtlas
+{
+public:
+    static const char Magic[8];
+
+    SpriteAtlas();
+
+    // loads the metadata and the atlas texture next to it, out of the
+    // resource pack when it holds them
+    bool loadFromFile(const std::string& path);
+
+    // loads the metadata only, the texture at getTexturePath() is left to
+    // the caller, e.g. an AssetLoader
+    bool loadMetadataFromFile(const std::string& path);
+    const std::string& getTexturePath() const;
+
+    sf::Texture& getTexture();
+    const sf::Texture& getTexture() const;
+
+    // rect of a cell in the original sheet; false when the atlas lacks it
+    bool findFrame(const sf::IntRect& source, sf::IntRect& rect, sf::Vector2f& offset) const;
+
+    std::size_t getFrameCount() const;
+
+private:
+    SpriteAtlas(const SpriteAtlas&);
+    SpriteAtlas& operator=(const SpriteAtlas&);
+
+    sf::Texture m_texture;
+    std::string m_texturePath;
+    std::vector<SpriteAtlasRecord> m_records;
+    std::map<std::pair<int, int>, std::size_t> m_lookup;
+};
+
+#endif // SPRITEATLAS_INCLUDE
@@ -0,0 +1,92 @@
+//============================================================================
+// Name        : SpriteBatch.cpp
+// Description : draws many animated sprites with one draw call per texture
+//============================================================================
+
+#include "SpriteBatch.hpp"
+
+SpriteBatch::SpriteBatch() : m_usedBatches(0), m_spriteCount(0), m_culledCount(0), m_isCulling(false)
+{
+
+}
+
+void SpriteBatch::setCullBounds(const sf::FloatRect& bounds)
+{
+    m_cullBounds = bounds;
+    m_isCulling = true;
+}
+
+void SpriteBatch::clear()
+{
+    for (std::size_t i = 0; i < m_usedBatches; ++i)
+        m_batches[i].vertices.clear();
+    m_usedBatches = 0;
+    m_spriteCount = 0;
+    m_culledCount = 0;
+}
+
+void SpriteBatch::add(const AnimatedSprite& sprite)
+{
+    const sf::Texture* texture = sprite.getTexture();
+    if (!texture)
+        return;
+
+    if (m_isCulling && !m_cullBounds.intersects(sprite.getGlobalBounds()))
+    {
+        ++m_culledCount;
+        return;
+    }
+
+    // a handful of textures per frame, a linear search beats any map
+    std::size_t i = 0;
+    while (i < m_usedBatches && m_batches[i].texture != texture)
+        ++i;
+
+    if (i == m_usedBatches)
+    {
+        if (m_usedBatches == m_batches.size())
+        {
+            m_batches.push_back(Batch());
+            m_batches.back().vertices.setPrimitiveType(sf::Quads);
+        }
+        m_batches[i].texture = texture;
+        ++m_usedBatches;
+    }
+
+    sprite.appendQuad(m_batches[i].vertices);
+    ++m_spriteCount;
+}
+
+std::size_t SpriteBatch::getDrawCalls() const
+{
+    return m_usedBatches;
+}
+
+const sf::Texture* SpriteBatch::getTexture(std::size_t call) const
+{
+    return m_batches[call].texture;
+}
+
+std::size_t SpriteBatch::getVertexCount(std::size_t call) const
+{
+    return m_batches[call].vertices.getVertexCount();
+}
+
+std::size_t SpriteBatch::getSpriteCount() const
+{
+    return m_spriteCount;
+}
+
+std::size_t SpriteBatch::getCulledCount() const
+{
+    return m_culledCount;
+}
+
+void SpriteBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    for (std::size_t i = 0; i < m_usedBatches; ++i)
+    {
+        states.texture = m_batches[i].texture;
+        target.draw(m_batches[i].vertices, states);
+    }
+}
@@ -0,0 +1,58 @@
+//============================================================================
+// Name        : SpriteBatch.hpp
+// Description : draws many animated sprites with one draw call per texture
+//============================================================================
+
+#ifndef SPRITEBATCH_INCLUDE
+#define SPRITEBATCH_INCLUDE
+
+#include <vector>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+#include "AnimatedSprite.hpp"
+
+// Quads are grouped by texture in the order each texture is first added, so
+// sprites should be added back to front; a sprite sharing a texture with an
+// earlier layer is drawn with that layer. Vertex storage is kept between
+// frames.
+class SpriteBatch : public sf::Drawable
+{
+public:
+    SpriteBatch();
+
+    // sprites entirely outside bounds are skipped, usually the visible view
+    void setCullBounds(const sf::FloatRect& bounds);
+
+    void clear();
+    void add(const AnimatedSprite& sprite);
+
+    std::size_t getDrawCalls() const;
+    // texture and vertices of each draw call, in drawing order
+    const sf::Texture* getTexture(std::size_t call) const;
+    std::size_t getVertexCount(std::size_t call) const;
+    std::size_t getSpriteCount() const;
+    std::size_t getCulledCount() const;
+
+private:
+    struct Batch
+    {
+        const sf::Texture* texture;
+        sf::VertexArray vertices;
+    };
+
+    virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+
+    std::vector<Batch> m_batches;
+    std::size_t m_usedBatches;
+    std::size_t m_spriteCount;
+    std::size_t m_culledCount;
+    sf::FloatRect m_cullBounds;
+    bool m_isCulling;
+};
+
+#endif // SPRITEBATCH_INCLUDE
@@ -0,0 +1,75 @@
+//============================================================================
+// Name        : SpscQueue.hpp
+// Description : bounded lock-free single producer / single consumer queue
+//============================================================================
+
+#ifndef SPSCQUEUE_INCLUDE
+#define SPSCQUEUE_INCLUDE
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// One thread pushes, one thread pops. Neither blocks: a full queue refuses
+// the push and an empty one the pop, the caller decides what to drop.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t capacity) : m_slots(capacity + 1), m_head(0), m_tail(0)
+    {
+
+    }
+
+    // producer
+    bool tryPush(const T& value)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t next = increment(tail);
+        if (next == m_head.load(std::memory_order_acquire))
+            return false;
+        m_slots[tail] = value;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer
+    bool tryPop(T& value)
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        value = m_slots[head];
+        m_head.store(increment(head), std::memory_order_release);
+        return true;
+    }
+
+    // approximate when called while the other side is running
+    std::size_t getSize() const
+    {
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : tail + m_slots.size() - head;
+    }
+
+    std::size_t getCapacity() const
+    {
+        return m_slots.size() - 1;
+    }
+
+private:
+    SpscQueue(const SpscQueue&);
+    SpscQueue& operator=(const SpscQueue&);
+
+    std::size_t increment(std::size_t i) const
+    {
+        return i + 1 == m_slots.size() ? 0 : i + 1;
+    }
+
+    std::vector<T> m_slots;
+    // head and tail on their own cache lines so both sides do not share one
+    alignas(64) std::atomic<std::size_t> m_head;
+    alignas(64) std::atomic<std::size_t> m_tail;
+};
+
+#endif // SPSCQUEUE_INCLUDE
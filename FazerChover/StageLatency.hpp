@@ -0,0 +1,67 @@
+//============================================================================
+// Name        : StageLatency.hpp
+// Description : latency counters one thread updates and another one reads
+//============================================================================
+
+#ifndef STAGELATENCY_INCLUDE
+#define STAGELATENCY_INCLUDE
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+class StageLatency
+{
+public:
+    StageLatency() : m_count(0), m_total(0), m_max(0), m_last(0)
+    {
+
+    }
+
+    void add(std::chrono::steady_clock::duration elapsed)
+    {
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_total.fetch_add(us, std::memory_order_relaxed);
+        m_last.store(us, std::memory_order_relaxed);
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (us > max && !m_max.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
+    }
+
+    void reset()
+    {
+        m_count = 0;
+        m_total = 0;
+        m_max = 0;
+    }
+
+    uint64_t getCount() const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    // microseconds
+    uint64_t getAverage() const
+    {
+        uint64_t count = getCount();
+        return count > 0 ? m_total.load(std::memory_order_relaxed) / count : 0;
+    }
+
+    uint64_t getMax() const
+    {
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getLast() const
+    {
+        return m_last.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_total;
+    std::atomic<uint64_t> m_max;
+    std::atomic<uint64_t> m_last;
+};
+
+#endif // STAGELATENCY_INCLUDE
@@ -0,0 +1,145 @@
+//============================================================================
+// Name        : StreamingTexture.cpp
+// Description : live camera frames into a texture, only changed rows uploaded
+//============================================================================
+
+#include "StreamingTexture.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+const unsigned StreamingTexture::BandRows;
+
+namespace
+{
+    // one row of 3 byte pixels to RGBA in dst; true when dst now differs
+    // from previous
+    template <PixelOrder Order>
+    bool expandRow(const uint8_t* src, const uint32_t* previous, uint32_t* dst, unsigned width)
+    {
+        unsigned x = 0;
+        bool isChanged = false;
+#if defined(__SSSE3__)
+        // 16 pixels are 48 source bytes, 3 loads, and 4 RGBA stores; each
+        // store takes 4 pixels from 12 bytes realigned to the register start
+        const __m128i shuffle = Order == PixelOrderRgb ?
+            _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1) :
+            _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+        __m128i difference = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16) {
+            const uint8_t* s = src + x * 3;
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+            __m128i p[4];
+            p[0] = _mm_or_si128(_mm_shuffle_epi8(a, shuffle), alpha);
+            p[1] = _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle), alpha);
+            p[2] = _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle), alpha);
+            p[3] = _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle), alpha);
+            for (int i = 0; i < 4; i++) {
+                __m128i old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + x + 4 * i));
+                difference = _mm_or_si128(difference, _mm_xor_si128(old, p[i]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x + 4 * i), p[i]);
+            }
+        }
+        isChanged = _mm_movemask_epi8(_mm_cmpeq_epi8(difference, _mm_setzero_si128())) != 0xffff;
+#endif
+        for (; x < width; x++) {
+            const uint8_t* s = src + x * 3;
+            uint8_t bytes[4] = {Order == PixelOrderRgb ? s[0] : s[2], s[1], Order == PixelOrderRgb ? s[2] : s[0], 255};
+            std::memcpy(dst + x, bytes, sizeof(bytes));
+            isChanged = isChanged || dst[x] != previous[x];
+        }
+        return isChanged;
+    }
+}
+
+StreamingTexture::StreamingTexture(unsigned width, unsigned height) :
+m_width(width), m_height(height), m_back(0), m_uploadedRows(0), m_hasTexture(false)
+{
+    m_staging[0].assign(width * height, 0);
+    m_staging[1].assign(width * height, 0);
+}
+
+bool StreamingTexture::update(const uint8_t* pixels, std::size_t stride, PixelOrder order)
+{
+    if (!m_hasTexture) {
+        if (!m_texture.create(m_width, m_height)) {
+            std::cout << "fail create camera texture" << std::endl;
+            return false;
+        }
+        m_sprite.setTexture(m_texture, true);
+    }
+
+    std::vector<uint32_t>& staging = m_staging[m_back];
+    const std::vector<uint32_t>& shown = m_staging[1 - m_back];
+    m_uploadedRows = 0;
+    // first row of the run of changed bands not uploaded yet
+    unsigned runTop = m_height;
+    for (unsigned top = 0; top < m_height; top += BandRows) {
+        unsigned bottom = top + BandRows < m_height ? top + BandRows : m_height;
+        // a new texture has nothing to compare with
+        bool isChanged = !m_hasTexture;
+        for (unsigned y = top; y < bottom; y++) {
+            std::size_t offset = static_cast<std::size_t>(y) * m_width;
+            bool isRowChanged = order == PixelOrderRgb ?
+                expandRow<PixelOrderRgb>(pixels + y * stride, &shown[offset], &staging[offset], m_width) :
+                expandRow<PixelOrderBgr>(pixels + y * stride, &shown[offset], &staging[offset], m_width);
+            isChanged = isChanged || isRowChanged;
+        }
+
+        if (isChanged && runTop == m_height) {
+            runTop = top;
+        } else if (!isChanged && runTop != m_height) {
+            upload(staging, runTop, top);
+            runTop = m_height;
+        }
+    }
+    if (runTop != m_height)
+        upload(staging, runTop, m_height);
+
+    m_hasTexture = true;
+    m_back = 1 - m_back;
+    return true;
+}
+
+void StreamingTexture::upload(const std::vector<uint32_t>& staging, unsigned top, unsigned bottom)
+{
+    // whole rows, so the rect is contiguous in the staging buffer
+    const uint32_t* rows = &staging[static_cast<std::size_t>(top) * m_width];
+    m_texture.update(reinterpret_cast<const sf::Uint8*>(rows), m_width, bottom - top, 0, top);
+    m_uploadedRows += bottom - top;
+}
+
+unsigned StreamingTexture::getUploadedRows() const
+{
+    return m_uploadedRows;
+}
+
+const sf::Texture& StreamingTexture::getTexture() const
+{
+    return m_texture;
+}
+
+unsigned StreamingTexture::getWidth() const
+{
+    return m_width;
+}
+
+unsigned StreamingTexture::getHeight() const
+{
+    return m_height;
+}
+
+void StreamingTexture::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    if (!m_hasTexture)
+        return;
+    states.transform *= getTransform();
+    target.draw(m_sprite, states);
+}
@@ -0,0 +1,62 @@
+//============================================================================
+// Name        : StreamingTexture.hpp
+// Description : live camera frames into a texture, only changed rows uploaded
+//============================================================================
+
+#ifndef STREAMINGTEXTURE_INCLUDE
+#define STREAMINGTEXTURE_INCLUDE
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Transformable.hpp>
+
+#include "PixelOrder.hpp"
+
+// Each frame is expanded to RGBA into one of two staging buffers while being
+// compared with the other one, which holds what the texture already shows.
+// The frame is split in bands of BandRows rows and runs of changed bands go
+// up with one sf::Texture::update each; identical bands are not uploaded.
+class StreamingTexture : public sf::Drawable, public sf::Transformable
+{
+public:
+    static const unsigned BandRows = 16;
+
+    explicit StreamingTexture(unsigned width = 640, unsigned height = 480);
+
+    // pixels is width x height, 3 bytes per pixel, rows stride bytes apart.
+    // Creates the texture on first use, false when that fails
+    bool update(const uint8_t* pixels, std::size_t stride, PixelOrder order);
+
+    // rows sent to the texture by the last update
+    unsigned getUploadedRows() const;
+
+    const sf::Texture& getTexture() const;
+    unsigned getWidth() const;
+    unsigned getHeight() const;
+
+private:
+    StreamingTexture(const StreamingTexture&);
+    StreamingTexture& operator=(const StreamingTexture&);
+
+    virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+
+    void upload(const std::vector<uint32_t>& staging, unsigned top, unsigned bottom);
+
+    unsigned m_width;
+    unsigned m_height;
+    // m_staging[m_back] is written next, the other one matches the texture
+    std::vector<uint32_t> m_staging[2];
+    int m_back;
+    unsigned m_uploadedRows;
+    sf::Texture m_texture;
+    sf::Sprite m_sprite;
+    bool m_hasTexture;
+};
+
+#endif // STREAMINGTEXTURE_INCLUDE
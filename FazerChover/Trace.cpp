@@ -0,0 +1,164 @@
+//============================================================================
+// Name        : Trace.cpp
+// Description : scoped timers recorded per thread, dumped as a chrome trace
+//============================================================================
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    // buffers outlive their threads so a dump still shows them
+    struct Registry
+    {
+        Registry() : start(Trace::now()), startTime(std::chrono::steady_clock::now())
+        {
+
+        }
+
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Trace::Buffer> > buffers;
+        std::map<int, std::string> names;
+        uint64_t start;
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // ticks per microsecond, measured against steady_clock since the
+    // registry was created
+    double getTickRate(const Registry& registry)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        uint64_t ticks = Trace::now() - registry.start;
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - registry.startTime).count();
+        return us > 0 && ticks > 0 ? static_cast<double>(ticks) / us : 1.0;
+#else
+        (void)registry;
+        return 1000.0;
+#endif
+    }
+
+    void writeString(std::FILE* file, const std::string& value)
+    {
+        std::fputc('"', file);
+        for (std::size_t i = 0; i < value.size(); ++i)
+        {
+            char c = value[i];
+            if (c == '"' || c == '\\')
+                std::fputc('\\', file);
+            if (static_cast<unsigned char>(c) >= 0x20)
+                std::fputc(c, file);
+        }
+        std::fputc('"', file);
+    }
+}
+
+namespace Trace
+{
+    const std::size_t Buffer::Capacity;
+
+    Buffer::Buffer(int id) : m_head(0), m_id(id)
+    {
+
+    }
+
+    void Buffer::copyEvents(std::vector<Event>& events) const
+    {
+        events.clear();
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        uint64_t first = head > Capacity ? head - Capacity : 0;
+        for (uint64_t i = first; i < head; ++i)
+            events.push_back(m_events[i & (Capacity - 1)]);
+
+        // the writer may have lapped the copy meanwhile: slots it reached
+        // since hold newer events, drop them
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = m_head.load(std::memory_order_relaxed);
+        uint64_t valid = after >= Capacity ? after - Capacity + 1 : 0;
+        if (valid > first)
+            events.erase(events.begin(), events.begin() + std::min<uint64_t>(valid - first, events.size()));
+    }
+
+    int Buffer::getId() const
+    {
+        return m_id;
+    }
+
+    Buffer* registerThread()
+    {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.push_back(std::unique_ptr<Buffer>(new Buffer(static_cast<int>(registry.buffers.size()) + 1)));
+        return registry.buffers.back().get();
+    }
+
+    void setThreadName(const std::string& name)
+    {
+        int id = getBuffer().getId();
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.names[id] = name;
+    }
+
+    bool writeChromeTrace(const std::string& path)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (!file)
+        {
+            std::cout << "fail write trace " << path << std::endl;
+            return false;
+        }
+
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        double rate = getTickRate(registry);
+
+        std::fputs("{\"traceEvents\":[\n", file);
+        bool first = true;
+        for (std::map<int, std::string>::const_iterator it = registry.names.begin(); it != registry.names.end(); ++it)
+        {
+            std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", it->first);
+            writeString(file, it->second);
+            std::fputs("}}", file);
+            first = false;
+        }
+
+        std::vector<Event> events;
+        for (std::size_t i = 0; i < registry.buffers.size(); ++i)
+        {
+            registry.buffers[i]->copyEvents(events);
+            for (std::size_t j = 0; j < events.size(); ++j)
+            {
+                // scopes from before the registry existed cannot be placed
+                if (events[j].start < registry.start || events[j].end < events[j].start)
+                    continue;
+                std::fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+                writeString(file, events[j].name);
+                std::fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                             registry.buffers[i]->getId(), (events[j].start - registry.start) / rate, (events[j].end - events[j].start) / rate);
+                first = false;
+            }
+        }
+        std::fputs("\n]}\n", file);
+
+        bool written = std::ferror(file) == 0;
+        if (std::fclose(file) != 0 || !written)
+        {
+            std::cout << "fail write trace " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,119 @@
+//============================================================================
+// Name        : Trace.hpp
+// Description : scoped timers recorded per thread, dumped as a chrome trace
+//============================================================================
+
+#ifndef TRACE_INCLUDE
+#define TRACE_INCLUDE
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// TRACE_SCOPE("name") times the rest of the enclosing block. Each thread
+// writes into its own ring buffer with no lock and no allocation: two clock
+// reads and one store, so scopes can stay in release builds. Only the last
+// Capacity scopes of each thread are kept. writeChromeTrace dumps them as
+// trace event json for chrome://tracing or ui.perfetto.dev; it can run while
+// the other threads keep tracing. Names must be string literals.
+namespace Trace
+{
+    struct Event
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    class Buffer
+    {
+    public:
+        static const std::size_t Capacity = 1 << 14;
+
+        explicit Buffer(int id);
+
+        // owning thread
+        void add(const char* name, uint64_t start, uint64_t end)
+        {
+            uint64_t head = m_head.load(std::memory_order_relaxed);
+            Event& event = m_events[head & (Capacity - 1)];
+            event.name = name;
+            event.start = start;
+            event.end = end;
+            m_head.store(head + 1, std::memory_order_release);
+        }
+
+        // any thread: the events still in the ring, oldest first; events
+        // overwritten during the copy are left out
+        void copyEvents(std::vector<Event>& events) const;
+        int getId() const;
+
+    private:
+        Buffer(const Buffer&);
+        Buffer& operator=(const Buffer&);
+
+        Event m_events[Capacity];
+        std::atomic<uint64_t> m_head;
+        int m_id;
+    };
+
+    // ticks, converted to microseconds when written
+    inline uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    Buffer* registerThread();
+
+    // buffer of the calling thread, registered on first use
+    inline Buffer& getBuffer()
+    {
+        static thread_local Buffer* buffer = NULL;
+        if (!buffer)
+            buffer = registerThread();
+        return *buffer;
+    }
+
+    // shown in the viewer instead of the thread number
+    void setThreadName(const std::string& name);
+
+    bool writeChromeTrace(const std::string& path);
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name) : m_name(name), m_start(now())
+        {
+
+        }
+
+        ~Scope()
+        {
+            getBuffer().add(m_name, m_start, now());
+        }
+
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+        const char* m_name;
+        uint64_t m_start;
+    };
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACE_INCLUDE
@@ -0,0 +1,77 @@
+//============================================================================
+// Name        : TripleBuffer.hpp
+// Description : lock-free single producer / single consumer frame exchange
+//============================================================================
+
+#ifndef TRIPLEBUFFER_INCLUDE
+#define TRIPLEBUFFER_INCLUDE
+
+#include <atomic>
+#include <cstddef>
+
+// Three slots: the producer owns the back slot, the consumer owns the front
+// slot and the middle one is handed over with a single atomic exchange.
+// Neither side ever waits for the other and no slot is copied on exchange.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : m_middle(1), m_back(0), m_front(2)
+    {
+
+    }
+
+    // setup only, before the producer starts publishing
+    T& getSlot(std::size_t i)
+    {
+        return m_slots[i];
+    }
+
+    // producer: slot to fill with the next frame
+    T& getBackBuffer()
+    {
+        return m_slots[m_back];
+    }
+
+    // producer: make the back slot the latest frame and take the stale one
+    void publish()
+    {
+        unsigned previous = m_middle.exchange(m_back | FreshBit, std::memory_order_acq_rel);
+        m_back = previous & IndexMask;
+    }
+
+    // consumer: take the latest frame if one was published since last claim
+    bool claim()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & FreshBit) == 0)
+            return false;
+        unsigned previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & IndexMask;
+        return true;
+    }
+
+    // consumer: frame returned by the last successful claim
+    T& getFrontBuffer()
+    {
+        return m_slots[m_front];
+    }
+
+    const T& getFrontBuffer() const
+    {
+        return m_slots[m_front];
+    }
+
+private:
+    static const unsigned IndexMask = 3;
+    static const unsigned FreshBit = 4;
+
+    TripleBuffer(const TripleBuffer&);
+    TripleBuffer& operator=(const TripleBuffer&);
+
+    T m_slots[3];
+    std::atomic<unsigned> m_middle;
+    unsigned m_back;
+    unsigned m_front;
+};
+
+#endif // TRIPLEBUFFER_INCLUDE
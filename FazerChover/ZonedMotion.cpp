@@ -0,0 +1,172 @@
+//============================================================================
+// Name        : ZonedMotion.cpp
+// Description : per tile motion counts over a grid laid on the depth frame
+//============================================================================
+
+#include "ZonedMotion.hpp"
+#include "MotionCounter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ZonedMotion::ZonedMotion(int width, int height, int columns, int rows) :
+m_width(width), m_height(height), m_columns(0), m_rows(0), m_background(NULL), m_totalChanged(0), m_activeArea(0), m_hasPrevious(false)
+{
+    setGrid(columns, rows);
+}
+
+void ZonedMotion::setGrid(int columns, int rows)
+{
+    m_columns = std::max(1, std::min(columns, m_width));
+    m_rows = std::max(1, std::min(rows, m_height));
+    
+    m_rowTile.resize(m_height);
+    for (int y = 0; y < m_height; y++)
+        m_rowTile[y] = y * m_rows / m_height;
+    
+    m_changed.assign(m_columns * m_rows, 0);
+    if (m_mask.empty())
+        clearMask();
+    else
+        setMask(m_mask);
+}
+
+int ZonedMotion::getColumns() const
+{
+    return m_columns;
+}
+
+int ZonedMotion::getRows() const
+{
+    return m_rows;
+}
+
+int ZonedMotion::getTileLeft(int column) const
+{
+    return column * m_width / m_columns;
+}
+
+int ZonedMotion::getTileTop(int row) const
+{
+    return row * m_height / m_rows;
+}
+
+void ZonedMotion::setMask(const cv::Mat& mask)
+{
+    m_mask = mask;
+    m_active.assign(m_columns * m_rows, 0);
+    m_activeArea = 0;
+    
+    for (int row = 0; row < m_rows; row++) {
+        int top = row * mask.rows / m_rows;
+        int bottom = std::max(top + 1, (row + 1) * mask.rows / m_rows);
+        for (int column = 0; column < m_columns; column++) {
+            int left = column * mask.cols / m_columns;
+            int right = std::max(left + 1, (column + 1) * mask.cols / m_columns);
+            bool active = false;
+            for (int y = top; y < bottom && !active; y++) {
+                const uchar* p = mask.ptr<uchar>(y);
+                for (int x = left; x < right && !active; x++)
+                    active = p[x] != 0;
+            }
+            m_active[row * m_columns + column] = active;
+            if (active)
+                m_activeArea += (getTileLeft(column + 1) - getTileLeft(column)) * (getTileTop(row + 1) - getTileTop(row));
+        }
+    }
+    // newly active tiles have no previous frame to compare with
+    m_hasPrevious = false;
+}
+
+void ZonedMotion::clearMask()
+{
+    m_mask = cv::Mat();
+    m_active.assign(m_columns * m_rows, 1);
+    m_activeArea = m_width * m_height;
+}
+
+bool ZonedMotion::isActive(int column, int row) const
+{
+    return m_active[row * m_columns + column] != 0;
+}
+
+void ZonedMotion::setBackgroundModel(BackgroundModel* model)
+{
+    m_background = model;
+    m_hasPrevious = false;
+}
+
+BackgroundModel* ZonedMotion::getBackgroundModel() const
+{
+    return m_background;
+}
+
+std::size_t ZonedMotion::process(const uint16_t* depth, const uint8_t* previous, uint8_t* current)
+{
+    std::fill(m_changed.begin(), m_changed.end(), 0);
+    if (!m_hasPrevious)
+        previous = NULL;
+    
+    for (int y = 0; y < m_height; y++) {
+        int row = m_rowTile[y];
+        const unsigned char* active = &m_active[row * m_columns];
+        std::size_t* changed = &m_changed[row * m_columns];
+        std::size_t offset = static_cast<std::size_t>(y) * m_width;
+        
+        for (int column = 0; column < m_columns; column++) {
+            if (!active[column])
+                continue;
+            std::size_t left = offset + getTileLeft(column);
+            std::size_t count = getTileLeft(column + 1) - getTileLeft(column);
+            if (m_background)
+                changed[column] += m_background->apply(depth + left, current + left, left, count, !m_hasPrevious);
+            else
+                changed[column] += countMotionPixels(depth + left, previous ? previous + left : NULL, current + left, count);
+        }
+    }
+    
+    m_hasPrevious = true;
+    m_totalChanged = 0;
+    for (std::size_t i = 0; i < m_changed.size(); i++)
+        m_totalChanged += m_changed[i];
+    return m_totalChanged;
+}
+
+std::size_t ZonedMotion::getChangedPixels(int column, int row) const
+{
+    return m_changed[row * m_columns + column];
+}
+
+double ZonedMotion::getActivity(int column, int row) const
+{
+    int area = (getTileLeft(column + 1) - getTileLeft(column)) * (getTileTop(row + 1) - getTileTop(row));
+    return static_cast<double>(getChangedPixels(column, row)) / area;
+}
+
+double ZonedMotion::getActivity(double left, double top, double width, double height) const
+{
+    // right and bottom edges are exclusive: an area ending on a tile
+    // boundary, or within rounding of it, does not touch the next tile
+    const double tolerance = 1e-9;
+    int firstColumn = std::max(0, static_cast<int>(std::floor(left * m_columns + tolerance)));
+    int lastColumn = std::min(m_columns - 1, static_cast<int>(std::ceil((left + width) * m_columns - tolerance)) - 1);
+    int firstRow = std::max(0, static_cast<int>(std::floor(top * m_rows + tolerance)));
+    int lastRow = std::min(m_rows - 1, static_cast<int>(std::ceil((top + height) * m_rows - tolerance)) - 1);
+    
+    std::size_t changed = 0;
+    std::size_t area = 0;
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            if (!isActive(column, row))
+                continue;
+            changed += getChangedPixels(column, row);
+            area += (getTileLeft(column + 1) - getTileLeft(column)) * (getTileTop(row + 1) - getTileTop(row));
+        }
+    }
+    return area > 0 ? static_cast<double>(changed) / area : 0;
+}
+
+double ZonedMotion::getActivity() const
+{
+    return m_activeArea > 0 ? static_cast<double>(m_totalChanged) / m_activeArea : 0;
+}
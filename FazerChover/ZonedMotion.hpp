@@ -0,0 +1,73 @@
+//============================================================================
+// Name        : ZonedMotion.hpp
+// Description : per tile motion counts over a grid laid on the depth frame
+//============================================================================
+
+#ifndef ZONEDMOTION_INCLUDE
+#define ZONEDMOTION_INCLUDE
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+#include "BackgroundModel.hpp"
+
+// Splits the frame into columns x rows tiles and counts changed pixels per
+// tile (see countMotionPixels) in one row by row pass. Tiles outside the mask
+// are neither converted nor compared. With a background model the count is
+// of foreground pixels instead, and current receives the foreground mask.
+class ZonedMotion
+{
+public:
+    ZonedMotion(int width = 640, int height = 480, int columns = 8, int rows = 6);
+    
+    void setGrid(int columns, int rows);
+    int getColumns() const;
+    int getRows() const;
+    
+    // CV_8UC1 of any size stretched over the frame; a tile is active when
+    // any mask pixel over it is non zero
+    void setMask(const cv::Mat& mask);
+    void clearMask();
+    bool isActive(int column, int row) const;
+    
+    // NULL compares consecutive frames; the model must cover the frame
+    void setBackgroundModel(BackgroundModel* model);
+    BackgroundModel* getBackgroundModel() const;
+    
+    // previous/current are 8 bit frames as in countMotionPixels; returns the
+    // changed pixels over all active tiles
+    std::size_t process(const uint16_t* depth, const uint8_t* previous, uint8_t* current);
+    
+    std::size_t getChangedPixels(int column, int row) const;
+    
+    // changed fraction of one tile
+    double getActivity(int column, int row) const;
+    
+    // changed fraction of the active tiles touching the area, in 0..1 frame coordinates
+    double getActivity(double left, double top, double width, double height) const;
+    
+    // changed fraction of all active tiles
+    double getActivity() const;
+    
+private:
+    int getTileLeft(int column) const;
+    int getTileTop(int row) const;
+    
+    int m_width;
+    int m_height;
+    int m_columns;
+    int m_rows;
+    std::vector<int> m_rowTile;
+    std::vector<unsigned char> m_active;
+    std::vector<std::size_t> m_changed;
+    cv::Mat m_mask;
+    BackgroundModel* m_background;
+    std::size_t m_totalChanged;
+    std::size_t m_activeArea;
+    bool m_hasPrevious;
+};
+
+#endif // ZONEDMOTION_INCLUDE
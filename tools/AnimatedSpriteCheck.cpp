@@ -0,0 +1,144 @@
+//============================================================================
+// Name        : AnimatedSpriteCheck.cpp
+// Description : AnimatedSprite long updates against one frame time at a time
+//============================================================================
+//
+// usage: AnimatedSpriteCheck
+//
+// update jumps over every frame a long delta spans in one step. For each
+// case two sprites play the same animation: one gets the deltas whole, the
+// other the same deltas cut in pieces of at most one frame time, so it never
+// moves more than one position per update. After every delta both must show
+// the same frame, agree on playing or ended, and report the same iteration
+// result. Any difference fails the run.
+//
+// build: c++ -std=c++11 -O2 -I../FazerChover AnimatedSpriteCheck.cpp ../FazerChover/AnimatedSprite.cpp ../FazerChover/Animation.cpp ../FazerChover/SpriteAtlas.cpp ../FazerChover/AssetPack.cpp -lsfml-graphics -lsfml-system -o AnimatedSpriteCheck
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "AnimatedSprite.hpp"
+#include "Animation.hpp"
+
+namespace
+{
+    enum Deltas
+    {
+        FewFrames,      // up to 3 frame times
+        WholeAnimation, // up to twice the animation
+        WholePeriods    // k times the animation, exactly and 1us either side
+    };
+
+    struct Case
+    {
+        const char* name;
+        bool looped;
+        bool reverse;
+        bool holds;
+        bool toggleReverse; // flips the direction between some updates
+        Deltas deltas;
+    };
+
+    const Case Cases[] = {
+        {"loop",                    true,  false, false, false, FewFrames},
+        {"loop, held frames",       true,  false, true,  false, FewFrames},
+        {"loop reverse",            true,  true,  true,  false, FewFrames},
+        {"loop, direction changes", true,  false, true,  true,  FewFrames},
+        {"no loop",                 false, false, true,  false, WholeAnimation},
+        {"no loop reverse",         false, true,  true,  false, WholeAnimation},
+        {"loop, whole periods",     true,  false, true,  false, WholePeriods},
+        {"reverse, whole periods",  true,  true,  true,  false, WholePeriods},
+        {"no loop, whole periods",  false, false, true,  false, WholePeriods},
+    };
+
+    int random(int n)
+    {
+        return std::rand() % n;
+    }
+
+    sf::Int64 getDelta(const Case& c, sf::Int64 frameTime, sf::Int64 duration)
+    {
+        switch (c.deltas) {
+            case FewFrames:
+                return random(static_cast<int>(3 * frameTime));
+            case WholeAnimation:
+                return random(static_cast<int>(2 * duration));
+            default:
+                return (1 + random(50)) * duration + random(3) - 1;
+        }
+    }
+
+    // steps of at most one frame time, a zero delta still calls update
+    bool updateStepwise(AnimatedSprite& sprite, sf::Int64 delta, sf::Int64 frameTime)
+    {
+        bool result = sprite.update(sf::microseconds(std::min(delta, frameTime)));
+        for (delta -= frameTime; delta > 0; delta -= frameTime)
+            result = sprite.update(sf::microseconds(std::min(delta, frameTime)));
+        return result;
+    }
+
+    // mismatching sequences
+    int run(const Case& c, int sequences)
+    {
+        int failures = 0;
+        for (int s = 0; s < sequences; s++) {
+            Animation animation;
+            int frameCount = 1 + random(8);
+            for (int i = 0; i < frameCount; i++)
+                animation.addFrame(sf::IntRect(i * 10, 0, 10, 10), c.holds ? 1 + random(4) : 1);
+            sf::Int64 frameTime = 1000 + random(100000);
+            sf::Int64 duration = frameTime * static_cast<sf::Int64>(animation.getSize());
+
+            AnimatedSprite jumping(sf::microseconds(frameTime), false, c.looped);
+            AnimatedSprite stepping(sf::microseconds(frameTime), false, c.looped);
+            AnimatedSprite* sprites[] = {&jumping, &stepping};
+            std::size_t start = random(static_cast<int>(animation.getSize()));
+            for (int i = 0; i < 2; i++) {
+                sprites[i]->play(animation);
+                sprites[i]->setFrameTime(sf::microseconds(frameTime));
+                sprites[i]->setMaxIteration(2);
+                sprites[i]->setPlayReverse(c.reverse);
+                sprites[i]->setFrame(start);
+            }
+
+            for (int u = 0; u < 30; u++) {
+                if (c.toggleReverse && random(4) == 0) {
+                    bool reverse = !jumping.isPlayingReverse();
+                    jumping.setPlayReverse(reverse);
+                    stepping.setPlayReverse(reverse);
+                }
+                sf::Int64 delta = getDelta(c, frameTime, duration);
+                bool jumped = jumping.update(sf::microseconds(delta));
+                bool stepped = updateStepwise(stepping, delta, frameTime);
+                if (jumped != stepped || jumping.getCurrentFrame() != stepping.getCurrentFrame() || jumping.isPlaying() != stepping.isPlaying()) {
+                    if (failures++ < 3)
+                        std::cout << "fail " << c.name << ": sequence " << s << " update " << u << " delta " << delta << "us"
+                                  << ", frame " << jumping.getCurrentFrame() << " instead of " << stepping.getCurrentFrame()
+                                  << ", playing " << jumping.isPlaying() << " instead of " << stepping.isPlaying()
+                                  << ", done " << jumped << " instead of " << stepped << std::endl;
+                    break;
+                }
+            }
+        }
+        return failures;
+    }
+}
+
+int main()
+{
+    std::srand(1);
+    const int sequences = 2000;
+    int failures = 0;
+    for (std::size_t i = 0; i < sizeof(Cases) / sizeof(Cases[0]); i++) {
+        int failed = run(Cases[i], sequences);
+        std::cout << Cases[i].name << ": " << sequences - failed << "/" << sequences << " sequences match" << std::endl;
+        failures += failed;
+    }
+    if (failures != 0) {
+        std::cout << "fail " << failures << " sequences" << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,277 @@
+//============================================================================
+// Name        : AnimationSystemCheck.cpp
+// Description : AnimationSystem instances against AnimatedSprite, timed
+//============================================================================
+//
+// usage: AnimationSystemCheck [instances]
+//
+// Plays the same animation on an AnimationSystem instance and on an
+// AnimatedSprite and fails on the first update where they show different
+// positions. Looped and not, forward and reverse (negative speed on the
+// system, play reverse on the sprite, the not looped one starting at the
+// end of the animation), with held frames.
+// - exact: frame times and deltas are multiples of 1/64s, which float
+//   represents exactly, so the two must agree on every update, deltas
+//   landing on frame boundaries and whole multiples of the animation
+//   included.
+// - near periods: k times the animation, exactly and a few microseconds
+//   either side, up to hours of play, in two updates; or one frame time per
+//   update for up to three periods, so rounding piles up a step either side
+//   of the animation's duration. The system's float clock cannot resolve
+//   that, so its position must be one the sprite shows within a few float
+//   steps of that time, and never one past the last.
+// Then [instances] / 10 and [instances] of each are updated to compare
+// their speed.
+//
+// build: c++ -std=c++11 -O2 -I../FazerChover AnimationSystemCheck.cpp ../FazerChover/AnimationSystem.cpp ../FazerChover/AnimatedSprite.cpp ../FazerChover/Animation.cpp ../FazerChover/SpriteAtlas.cpp ../FazerChover/AssetPack.cpp -lsfml-graphics -lsfml-system -o AnimationSystemCheck
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "AnimatedSprite.hpp"
+#include "Animation.hpp"
+#include "AnimationSystem.hpp"
+
+namespace
+{
+    // 1/64s, exact in float seconds and in sf::Time microseconds
+    const sf::Int64 Tick = 15625;
+
+    struct Case
+    {
+        const char* name;
+        bool looped;
+        bool reverse;
+    };
+
+    const Case Cases[] = {
+        {"loop",            true,  false},
+        {"loop reverse",    true,  true},
+        {"no loop",         false, false},
+        {"no loop reverse", false, true},
+    };
+
+    int random(int n)
+    {
+        return std::rand() % n;
+    }
+
+    void makeAnimation(Animation& animation, const sf::Texture& sheet, bool looped)
+    {
+        animation.setSpriteSheet(sheet);
+        animation.setLooped(looped);
+        int frameCount = 1 + random(8);
+        for (int i = 0; i < frameCount; i++)
+            animation.addFrame(sf::IntRect(i * 10, 0, 10, 10), 1 + random(3));
+    }
+
+    // a reversed instance that does not loop starts at the end, where the
+    // reversed sprite starts
+    std::size_t addInstance(AnimationSystem& system, const Animation& animation, sf::Int64 frameTime, const Case& c)
+    {
+        int id = system.addAnimation(animation, sf::microseconds(frameTime));
+        sf::Int64 duration = frameTime * static_cast<sf::Int64>(animation.getSize());
+        std::size_t instance = system.add(id, sf::Vector2f(), sf::microseconds(c.reverse && !c.looped ? duration : 0));
+        system.setLooped(instance, c.looped);
+        system.setSpeed(instance, c.reverse ? -1.f : 1.f);
+        return instance;
+    }
+
+    void startSprite(AnimatedSprite& sprite, const Animation& animation, sf::Int64 frameTime, const Case& c)
+    {
+        sprite.setLooped(c.looped);
+        sprite.play(animation);
+        sprite.setFrameTime(sf::microseconds(frameTime));
+        sprite.setPlayReverse(c.reverse);
+        sprite.setFrame(c.reverse ? animation.getSize() - 1 : 0);
+    }
+
+    std::size_t getSpriteFrame(const Animation& animation, sf::Int64 frameTime, const Case& c, sf::Int64 time)
+    {
+        AnimatedSprite sprite;
+        startSprite(sprite, animation, frameTime, c);
+        sprite.update(sf::microseconds(time));
+        return sprite.getCurrentFrame();
+    }
+
+    // mismatching sequences
+    int runExact(const Case& c, int sequences)
+    {
+        sf::Texture sheet;
+        int failures = 0;
+        for (int s = 0; s < sequences; s++) {
+            Animation animation;
+            makeAnimation(animation, sheet, c.looped);
+            sf::Int64 frameTime = Tick << random(5);
+            sf::Int64 duration = frameTime * static_cast<sf::Int64>(animation.getSize());
+
+            AnimationSystem system;
+            std::size_t instance = addInstance(system, animation, frameTime, c);
+            AnimatedSprite sprite;
+            startSprite(sprite, animation, frameTime, c);
+
+            sf::Int64 time = 0;
+            for (int u = 0; u < 40; u++) {
+                sf::Int64 delta;
+                switch (random(4)) {
+                    case 0:
+                        delta = (1 + random(3)) * duration;
+                        break;
+                    case 1:
+                        delta = Tick * random(static_cast<int>(2 * duration / Tick));
+                        break;
+                    default:
+                        delta = Tick * random(static_cast<int>(3 * frameTime / Tick));
+                        break;
+                }
+                time += delta;
+                system.update(sf::microseconds(delta));
+                sprite.update(sf::microseconds(delta));
+                if (system.getCurrentFrame(instance) != sprite.getCurrentFrame()) {
+                    if (failures++ < 3)
+                        std::cout << "fail " << c.name << ": sequence " << s << " update " << u << " at " << time << "us"
+                                  << ", length " << animation.getSize() << " frame time " << frameTime << "us"
+                                  << ", frame " << system.getCurrentFrame(instance) << " instead of " << sprite.getCurrentFrame() << std::endl;
+                    break;
+                }
+            }
+        }
+        return failures;
+    }
+
+    // float steps of the system's clock at seconds, in microseconds
+    sf::Int64 getFloatStep(float seconds)
+    {
+        return static_cast<sf::Int64>(std::ceil((std::nextafter(seconds, 2.f * seconds + 1.f) - seconds) * 1000000.f));
+    }
+
+    // whether frame is one the sprite shows within slack of time
+    bool isNear(std::size_t frame, const Animation& animation, sf::Int64 frameTime, const Case& c, sf::Int64 time, sf::Int64 slack)
+    {
+        if (frame >= animation.getSize())
+            return false;
+        return frame == getSpriteFrame(animation, frameTime, c, std::max<sf::Int64>(0, time - slack))
+            || frame == getSpriteFrame(animation, frameTime, c, time + slack);
+    }
+
+    int runNearPeriods(const Case& c, int checks)
+    {
+        sf::Texture sheet;
+        int failures = 0;
+        for (int n = 0; n < checks; n++) {
+            Animation animation;
+            makeAnimation(animation, sheet, c.looped);
+            sf::Int64 frameTime = 1000 + random(200000);
+            sf::Int64 duration = frameTime * static_cast<sf::Int64>(animation.getSize());
+            AnimationSystem system;
+            std::size_t instance = addInstance(system, animation, frameTime, c);
+
+            sf::Int64 time = 0;
+            sf::Int64 slack = 2;
+            bool isFailed = false;
+            if (random(2)) {
+                // k periods in two updates: the clock wraps a long delta and
+                // then adds a sum landing on the period
+                sf::Int64 periods = random(2) ? random(4) : random(2000);
+                time = std::max<sf::Int64>(0, periods * duration + random(7) - 3);
+                sf::Int64 first = std::min(time, time / (1 + random(4)) + random(1000));
+                system.update(sf::microseconds(first));
+                system.update(sf::microseconds(time - first));
+                slack += 8 * getFloatStep(static_cast<float>(time) / 1000000.f);
+                isFailed = !isNear(system.getCurrentFrame(instance), animation, frameTime, c, time, slack);
+            }
+            else {
+                // one frame time per update, as a game plays it: every update
+                // ends on a frame boundary and rounding piles up around the
+                // period, a step either side of duration
+                int updates = 1 + random(3 * static_cast<int>(animation.getSize()));
+                sf::Int64 step = 2 * getFloatStep(static_cast<float>(duration) / 1000000.f);
+                for (int u = 0; u < updates && !isFailed; u++) {
+                    time += frameTime;
+                    slack += step;
+                    system.update(sf::microseconds(frameTime));
+                    isFailed = !isNear(system.getCurrentFrame(instance), animation, frameTime, c, time, slack);
+                }
+            }
+            if (isFailed && failures++ < 3)
+                std::cout << "fail " << c.name << ": " << time << "us, length " << animation.getSize()
+                          << " frame time " << frameTime << "us, frame " << system.getCurrentFrame(instance)
+                          << " instead of " << getSpriteFrame(animation, frameTime, c, time) << std::endl;
+        }
+        return failures;
+    }
+
+    void benchmark(std::size_t count)
+    {
+        sf::Texture sheet;
+        Animation animation;
+        animation.setSpriteSheet(sheet);
+        for (int i = 0; i < 6; i++)
+            animation.addFrame(sf::IntRect(i * 8, 0, 8, 16));
+        sf::Time frameTime = sf::milliseconds(50);
+        sf::Time deltaTime = sf::milliseconds(16);
+        const int updates = 100;
+
+        AnimationSystem system;
+        int id = system.addAnimation(animation, frameTime);
+        for (std::size_t i = 0; i < count; i++) {
+            std::size_t instance = system.add(id, sf::Vector2f(static_cast<float>(random(1024)), static_cast<float>(random(768))), sf::microseconds(random(300000)));
+            system.setVelocity(instance, sf::Vector2f(0.f, 400.f));
+        }
+        // the way a layer of AnimatedSprites is kept
+        std::vector<AnimatedSprite*> sprites(count);
+        for (std::size_t i = 0; i < count; i++) {
+            sprites[i] = new AnimatedSprite(frameTime);
+            sprites[i]->play(animation);
+            sprites[i]->setFrame(random(static_cast<int>(animation.getSize())));
+            sprites[i]->setPosition(static_cast<float>(random(1024)), static_cast<float>(random(768)));
+        }
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int u = 0; u < updates; u++)
+            system.update(deltaTime);
+        double systemTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / updates;
+
+        begin = std::chrono::steady_clock::now();
+        for (int u = 0; u < updates; u++) {
+            for (std::size_t i = 0; i < count; i++) {
+                sprites[i]->update(deltaTime);
+                sprites[i]->move(0.f, 400.f * deltaTime.asSeconds());
+            }
+        }
+        double spriteTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / updates;
+
+        std::cout << count << " instances: AnimationSystem " << systemTime << "us, AnimatedSprite " << spriteTime << "us per update" << std::endl;
+        for (std::size_t i = 0; i < count; i++)
+            delete sprites[i];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t instances = argc > 1 ? std::atoi(argv[1]) : 100000;
+    std::srand(1);
+    const int sequences = 2000;
+    int failures = 0;
+    for (std::size_t i = 0; i < sizeof(Cases) / sizeof(Cases[0]); i++) {
+        int failed = runExact(Cases[i], sequences);
+        std::cout << Cases[i].name << ", exact: " << sequences - failed << "/" << sequences << " sequences match" << std::endl;
+        failures += failed;
+        failed = runNearPeriods(Cases[i], sequences);
+        std::cout << Cases[i].name << ", near periods: " << sequences - failed << "/" << sequences << " updates match" << std::endl;
+        failures += failed;
+    }
+
+    benchmark(instances / 10);
+    benchmark(instances);
+
+    if (failures != 0) {
+        std::cout << "fail " << failures << " mismatches" << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
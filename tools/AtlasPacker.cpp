@@ -0,0 +1,307 @@
+//============================================================================
+// Name        : AtlasPacker.cpp
+// Description : offline packer turning grid sprite sheets into tight atlases
+//============================================================================
+//
+// usage: AtlasPacker <sheet.png> <cellWidth> <cellHeight> <output> [strideX strideY]
+//
+// Every cell of the sheet is trimmed to the bounding box of its non transparent
+// pixels, identical cells are stored once and the rest is shelf packed into
+// the smallest atlas that fits. Writes <output>.png and <output>.atlas, the
+// metadata read by SpriteAtlas; the output must not be named like the sheet,
+// which stays in the bundle as the fallback. The game loads the atlases named
+// in animations.xml and keeps using the sheet when one is missing.
+//
+// build: c++ -std=c++11 -O2 -I../FazerChover AtlasPacker.cpp ../FazerChover/SpriteAtlas.cpp ../FazerChover/AssetPack.cpp -lsfml-graphics -lsfml-system -o AtlasPacker
+//
+// sheets used by the game, from the resource folder; the results are
+// committed and in the bundle resources, rerun after editing a sheet:
+//   AtlasPacker cenario.png 222 170 cenario_atlas
+//   AtlasPacker start.png 222 170 start_atlas
+//   AtlasPacker end.png 222 177 end_atlas
+
+#include <SFML/Graphics/Image.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "SpriteAtlas.hpp"
+
+namespace
+{
+    const unsigned Padding = 1;
+    const unsigned MaxAtlasSize = 4096;
+
+    struct Cell
+    {
+        sf::IntRect source;
+        sf::IntRect trimmed;    // relative to the sheet, empty when transparent
+        std::size_t unique;     // index into the unique frames
+    };
+
+    struct Unique
+    {
+        std::size_t cell;       // first cell holding this image
+        unsigned x;
+        unsigned y;
+    };
+
+    sf::IntRect trimCell(const sf::Image& sheet, const sf::IntRect& cell)
+    {
+        const sf::Uint8* pixels = sheet.getPixelsPtr();
+        unsigned stride = sheet.getSize().x;
+        int left = cell.left + cell.width, right = cell.left - 1;
+        int top = cell.top + cell.height, bottom = cell.top - 1;
+
+        for (int y = cell.top; y < cell.top + cell.height; ++y)
+        {
+            const sf::Uint8* row = pixels + (static_cast<std::size_t>(y) * stride) * 4;
+            for (int x = cell.left; x < cell.left + cell.width; ++x)
+            {
+                if (row[x * 4 + 3] == 0)
+                    continue;
+                left = std::min(left, x);
+                right = std::max(right, x);
+                top = std::min(top, y);
+                bottom = std::max(bottom, y);
+            }
+        }
+
+        if (right < left)
+            return sf::IntRect();
+        return sf::IntRect(left, top, right - left + 1, bottom - top + 1);
+    }
+
+    // FNV-1a over the trimmed pixels, collisions are resolved by comparing
+    uint64_t hashRect(const sf::Image& sheet, const sf::IntRect& rect)
+    {
+        const sf::Uint8* pixels = sheet.getPixelsPtr();
+        unsigned stride = sheet.getSize().x;
+        uint64_t hash = 14695981039346656037ULL ^ (static_cast<uint64_t>(rect.width) << 32 | rect.height);
+        for (int y = rect.top; y < rect.top + rect.height; ++y)
+        {
+            const sf::Uint8* row = pixels + (static_cast<std::size_t>(y) * stride + rect.left) * 4;
+            for (int i = 0; i < rect.width * 4; ++i)
+            {
+                hash ^= row[i];
+                hash *= 1099511628211ULL;
+            }
+        }
+        return hash;
+    }
+
+    bool sameRect(const sf::Image& sheet, const sf::IntRect& a, const sf::IntRect& b)
+    {
+        if (a.width != b.width || a.height != b.height)
+            return false;
+        const sf::Uint8* pixels = sheet.getPixelsPtr();
+        unsigned stride = sheet.getSize().x;
+        for (int y = 0; y < a.height; ++y)
+        {
+            const sf::Uint8* rowA = pixels + (static_cast<std::size_t>(a.top + y) * stride + a.left) * 4;
+            const sf::Uint8* rowB = pixels + (static_cast<std::size_t>(b.top + y) * stride + b.left) * 4;
+            if (std::memcmp(rowA, rowB, a.width * 4) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    // shelf packing in the given width, tallest frames first; returns the used
+    // height or 0 when the frames do not fit
+    unsigned packShelves(std::vector<Unique>& uniques, const std::vector<Cell>& cells,
+                         const std::vector<std::size_t>& order, unsigned width)
+    {
+        unsigned x = 0, y = 0, shelfHeight = 0;
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            Unique& unique = uniques[order[i]];
+            const sf::IntRect& rect = cells[unique.cell].trimmed;
+            unsigned w = rect.width + Padding * 2;
+            unsigned h = rect.height + Padding * 2;
+            if (w > width)
+                return 0;
+            if (x + w > width)
+            {
+                y += shelfHeight;
+                x = 0;
+                shelfHeight = 0;
+            }
+            unique.x = x + Padding;
+            unique.y = y + Padding;
+            x += w;
+            shelfHeight = std::max(shelfHeight, h);
+            if (y + shelfHeight > MaxAtlasSize)
+                return 0;
+        }
+        return y + shelfHeight;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 5 && argc != 7)
+    {
+        std::cout << "usage: " << argv[0] << " <sheet.png> <cellWidth> <cellHeight> <output> [strideX strideY]" << std::endl;
+        return 1;
+    }
+
+    sf::Image sheet;
+    if (!sheet.loadFromFile(argv[1]))
+    {
+        std::cout << "fail load " << argv[1] << std::endl;
+        return 1;
+    }
+
+    int cellWidth = std::atoi(argv[2]);
+    int cellHeight = std::atoi(argv[3]);
+    std::string output = argv[4];
+    int strideX = argc == 7 ? std::atoi(argv[5]) : cellWidth;
+    int strideY = argc == 7 ? std::atoi(argv[6]) : cellHeight;
+    if (cellWidth <= 0 || cellHeight <= 0 || strideX < cellWidth || strideY < cellHeight)
+    {
+        std::cout << "invalid cell size" << std::endl;
+        return 1;
+    }
+
+    // trim and deduplicate every cell
+    std::vector<Cell> cells;
+    std::vector<Unique> uniques;
+    std::multimap<uint64_t, std::size_t> hashes;
+    std::size_t empty = 0;
+    sf::Vector2u size = sheet.getSize();
+    for (int top = 0; top + cellHeight <= static_cast<int>(size.y); top += strideY)
+    {
+        for (int left = 0; left + cellWidth <= static_cast<int>(size.x); left += strideX)
+        {
+            Cell cell;
+            cell.source = sf::IntRect(left, top, cellWidth, cellHeight);
+            cell.trimmed = trimCell(sheet, cell.source);
+            cell.unique = uniques.size();
+
+            if (cell.trimmed.width == 0)
+            {
+                ++empty;
+                cells.push_back(cell);
+                continue;
+            }
+
+            uint64_t hash = hashRect(sheet, cell.trimmed);
+            std::pair<std::multimap<uint64_t, std::size_t>::iterator, std::multimap<uint64_t, std::size_t>::iterator> range = hashes.equal_range(hash);
+            for (std::multimap<uint64_t, std::size_t>::iterator it = range.first; it != range.second; ++it)
+            {
+                if (sameRect(sheet, cells[uniques[it->second].cell].trimmed, cell.trimmed))
+                {
+                    cell.unique = it->second;
+                    break;
+                }
+            }
+
+            if (cell.unique == uniques.size())
+            {
+                Unique unique;
+                unique.cell = cells.size();
+                unique.x = 0;
+                unique.y = 0;
+                hashes.insert(std::make_pair(hash, uniques.size()));
+                uniques.push_back(unique);
+            }
+            cells.push_back(cell);
+        }
+    }
+
+    // tallest first, then widest
+    std::vector<std::size_t> order(uniques.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        const sf::IntRect& ra = cells[uniques[a].cell].trimmed;
+        const sf::IntRect& rb = cells[uniques[b].cell].trimmed;
+        return ra.height != rb.height ? ra.height > rb.height : ra.width > rb.width;
+    });
+
+    // smallest power of two width giving the least area
+    unsigned bestWidth = 0, bestHeight = 0;
+    for (unsigned width = 64; width <= MaxAtlasSize; width *= 2)
+    {
+        unsigned height = packShelves(uniques, cells, order, width);
+        if (height == 0)
+            continue;
+        if (bestWidth == 0 || static_cast<uint64_t>(width) * height < static_cast<uint64_t>(bestWidth) * bestHeight)
+        {
+            bestWidth = width;
+            bestHeight = height;
+        }
+    }
+    if (bestWidth == 0)
+    {
+        std::cout << "frames do not fit in " << MaxAtlasSize << "x" << MaxAtlasSize << std::endl;
+        return 1;
+    }
+    packShelves(uniques, cells, order, bestWidth);
+
+    sf::Image atlas;
+    atlas.create(bestWidth, std::max(bestHeight, 1u), sf::Color::Transparent);
+    for (std::size_t i = 0; i < uniques.size(); ++i)
+        atlas.copy(sheet, uniques[i].x, uniques[i].y, cells[uniques[i].cell].trimmed);
+
+    std::string textureName = output + ".png";
+    if (!atlas.saveToFile(textureName))
+    {
+        std::cout << "fail write " << textureName << std::endl;
+        return 1;
+    }
+
+    std::string::size_type slash = textureName.find_last_of('/');
+    std::string name = slash == std::string::npos ? textureName : textureName.substr(slash + 1);
+
+    std::vector<SpriteAtlasRecord> records(cells.size());
+    for (std::size_t i = 0; i < cells.size(); ++i)
+    {
+        const Cell& cell = cells[i];
+        SpriteAtlasRecord& record = records[i];
+        std::memset(&record, 0, sizeof(record));
+        record.sourceLeft = cell.source.left;
+        record.sourceTop = cell.source.top;
+        record.sourceWidth = cell.source.width;
+        record.sourceHeight = cell.source.height;
+        if (cell.trimmed.width == 0)
+            continue;
+        record.atlasLeft = uniques[cell.unique].x;
+        record.atlasTop = uniques[cell.unique].y;
+        record.width = cell.trimmed.width;
+        record.height = cell.trimmed.height;
+        record.offsetX = cell.trimmed.left - cell.source.left;
+        record.offsetY = cell.trimmed.top - cell.source.top;
+    }
+
+    std::string metadata = output + ".atlas";
+    std::FILE* file = std::fopen(metadata.c_str(), "wb");
+    uint32_t frameCount = static_cast<uint32_t>(records.size());
+    uint32_t nameLength = static_cast<uint32_t>(name.size());
+    bool written = file
+        && std::fwrite(SpriteAtlas::Magic, sizeof(SpriteAtlas::Magic), 1, file) == 1
+        && std::fwrite(&frameCount, sizeof(frameCount), 1, file) == 1
+        && std::fwrite(&nameLength, sizeof(nameLength), 1, file) == 1
+        && std::fwrite(name.data(), nameLength, 1, file) == 1
+        && (records.empty() || std::fwrite(&records[0], sizeof(SpriteAtlasRecord), records.size(), file) == records.size());
+    if (file)
+        written = std::fclose(file) == 0 && written;
+    if (!written)
+    {
+        std::cout << "fail write " << metadata << std::endl;
+        return 1;
+    }
+
+    std::cout << argv[1] << " " << size.x << "x" << size.y
+              << " -> " << textureName << " " << bestWidth << "x" << bestHeight
+              << ": " << cells.size() << " cells, " << uniques.size() << " unique, "
+              << empty << " empty" << std::endl;
+    return 0;
+}
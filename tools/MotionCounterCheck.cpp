@@ -0,0 +1,313 @@
+//============================================================================
+// Name        : MotionCounterCheck.cpp
+// Description : every countMotionPixels kernel against the scalar one, timed
+//============================================================================
+//
+// usage: MotionCounterCheck [frames] [recording]
+//
+// Runs each kernel the cpu supports on the same depth as the scalar
+// reference and fails on the first count or converted pixel that differs.
+// Depth is random over the whole 16 bit range and over the 11 bit one, edge
+// values (0, 2047, 2048, 65535) and the values where the 255/2024 scale
+// rounds half way. Lengths cover every tail size around the 16 and 32 pixel
+// vectors, the points where the byte counters are folded (255 vectors) and a
+// whole frame, at unaligned offsets, with and without a previous frame.
+//
+// Then [frames] 640x480 frames go through each kernel and through the three
+// pass OpenCV pipeline the game ran before (convertTo 255/2024 twice,
+// absdiff, counting with at<uchar>) to compare their speed. The frames are
+// those of [recording] (raw or compressed, played by ReplayFrameSource, the
+// first 100 with depth) when given, random ones otherwise. Every frame's
+// count must match the OpenCV one.
+//
+// build: c++ -std=c++11 -O2 -mavx2 -c ../FazerChover/MotionCounterAVX2.cpp -o MotionCounterAVX2.o
+//        c++ -std=c++11 -O2 -pthread -I../FazerChover MotionCounterCheck.cpp ../FazerChover/MotionCounter.cpp MotionCounterAVX2.o ../FazerChover/ReplayFrameSource.cpp ../FazerChover/DepthRecording.cpp ../FazerChover/Trace.cpp -lopencv_core -lopencv_imgproc -o MotionCounterCheck
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+#include "MotionCounter.hpp"
+#include "ReplayFrameSource.hpp"
+
+namespace
+{
+    const int FrameWidth = 640;
+    const int FrameHeight = 480;
+    const std::size_t FrameSize = FrameWidth * FrameHeight;
+    // recorded frames kept in memory for the timing, about 60MB
+    const std::size_t MaxRecordedFrames = 100;
+    // the largest length checked, plus room for the offsets
+    const std::size_t MaxLength = FrameSize + 64;
+
+    const char* getName(MotionKernel kernel)
+    {
+        switch (kernel) {
+            case MotionKernelScalar:
+                return "scalar";
+            case MotionKernelSSE2:
+                return "sse2";
+            case MotionKernelAVX2:
+                return "avx2";
+        }
+        return "?";
+    }
+
+    enum Pattern
+    {
+        RandomFull,   // any 16 bit value
+        RandomDepth,  // 11 bit values only
+        EdgeValues,
+        HalfWay,      // around the rounding boundaries of the scale
+        PatternCount
+    };
+
+    const char* getName(Pattern pattern)
+    {
+        switch (pattern) {
+            case RandomFull:
+                return "random 16 bit";
+            case RandomDepth:
+                return "random 11 bit";
+            case EdgeValues:
+                return "edge values";
+            case HalfWay:
+                return "half way";
+            default:
+                return "?";
+        }
+    }
+
+    void fill(std::vector<uint16_t>& depth, Pattern pattern)
+    {
+        static const uint16_t edges[] = {0, 1, 2023, 2024, 2025, 2046, 2047, 2048, 2049, 4095, 32767, 32768, 65534, 65535};
+        // i with i * 255 / 2024 closest to x.5, both sides
+        std::vector<uint16_t> halfWay;
+        for (int i = 0; i < 2048; i++) {
+            double scaled = i * (255.0 / 2024.0);
+            if (std::fabs(scaled - std::floor(scaled) - 0.5) < 0.07)
+                halfWay.push_back(static_cast<uint16_t>(i));
+        }
+
+        for (std::size_t i = 0; i < depth.size(); i++) {
+            switch (pattern) {
+                case RandomFull:
+                    depth[i] = static_cast<uint16_t>(std::rand() & 0xffff);
+                    break;
+                case RandomDepth:
+                    depth[i] = static_cast<uint16_t>(std::rand() & 0x7ff);
+                    break;
+                case EdgeValues:
+                    depth[i] = edges[std::rand() % (sizeof(edges) / sizeof(edges[0]))];
+                    break;
+                default:
+                    depth[i] = halfWay[std::rand() % halfWay.size()];
+                    break;
+            }
+        }
+    }
+
+    std::vector<std::size_t> getLengths()
+    {
+        std::vector<std::size_t> lengths;
+        for (std::size_t n = 0; n <= 70; n++)
+            lengths.push_back(n);
+        const std::size_t folds[] = {255 * 16, 255 * 32, 2 * 255 * 32};
+        for (std::size_t f = 0; f < sizeof(folds) / sizeof(folds[0]); f++) {
+            for (std::size_t n = folds[f] - 33; n <= folds[f] + 33; n++)
+                lengths.push_back(n);
+        }
+        lengths.push_back(FrameSize - 1);
+        lengths.push_back(FrameSize);
+        lengths.push_back(FrameSize + 17);
+        return lengths;
+    }
+
+    // previous is NULL, what the reference produced (nothing changed), or
+    // that with every few pixels altered
+    enum Previous
+    {
+        NoPrevious,
+        SamePrevious,
+        ChangedPrevious,
+        PreviousCount
+    };
+
+    std::size_t failures = 0;
+
+    void check(MotionKernel kernel, const std::vector<uint16_t>& depth, Pattern pattern)
+    {
+        std::vector<std::size_t> lengths = getLengths();
+        std::vector<uint8_t> reference(MaxLength), result(MaxLength), previous(MaxLength);
+        const std::size_t offsets[] = {0, 1, 3, 7};
+
+        for (std::size_t l = 0; l < lengths.size(); l++) {
+            std::size_t count = lengths[l];
+            for (std::size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++) {
+                std::size_t offset = offsets[o];
+                for (int p = 0; p < PreviousCount; p++) {
+                    setMotionKernel(MotionKernelScalar);
+                    countMotionPixels(&depth[offset], NULL, &previous[offset], count);
+                    if (p == ChangedPrevious) {
+                        for (std::size_t i = offset; i < offset + count; i += 1 + std::rand() % 5)
+                            previous[i] = static_cast<uint8_t>(previous[i] + 1 + std::rand() % 255);
+                    }
+                    const uint8_t* before = p == NoPrevious ? NULL : &previous[offset];
+
+                    // the output must also be left alone past count
+                    std::memset(&reference[0], 0xa5, reference.size());
+                    std::memset(&result[0], 0xa5, result.size());
+                    std::size_t expected = countMotionPixels(&depth[offset], before, &reference[offset], count);
+                    setMotionKernel(kernel);
+                    std::size_t changed = countMotionPixels(&depth[offset], before, &result[offset], count);
+
+                    if (changed != expected || std::memcmp(&result[0], &reference[0], result.size()) != 0) {
+                        if (failures++ < 10)
+                            std::cout << "fail " << getName(kernel) << " " << getName(pattern) << " length " << count
+                                      << " offset " << offset << " previous " << p
+                                      << ": " << changed << " changed, expected " << expected << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    typedef std::vector<std::vector<uint16_t> > Frames;
+
+    // false when path cannot be played
+    bool loadRecording(const char* path, Frames& frames)
+    {
+        ReplayFrameSource replay;
+        if (!replay.openFromFile(path, ReplayFrameSource::MaxSpeed))
+            return false;
+        replay.setLooped(false);
+        replay.start();
+        while (!replay.isFinished() && frames.size() < MaxRecordedFrames) {
+            cv::Mat depth;
+            if (replay.getDepth(depth)) {
+                const uint16_t* samples = depth.ptr<uint16_t>();
+                frames.push_back(std::vector<uint16_t>(samples, samples + FrameSize));
+            }
+        }
+        replay.stop();
+        return !frames.empty();
+    }
+
+    void makeRandomFrames(Frames& frames)
+    {
+        frames.assign(8, std::vector<uint16_t>(FrameSize));
+        for (std::size_t f = 0; f < frames.size(); f++)
+            fill(frames[f], RandomDepth);
+    }
+
+    // changed pixels of every frame against the one before, 0 for the first
+    double benchmark(MotionKernel kernel, const Frames& inputs, int frames, std::vector<std::size_t>& counts)
+    {
+        std::vector<uint8_t> previous(FrameSize), current(FrameSize);
+        setMotionKernel(kernel);
+        counts.assign(frames, 0);
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            counts[f] = countMotionPixels(&inputs[f % inputs.size()][0], f == 0 ? NULL : &previous[0], &current[0], FrameSize);
+            previous.swap(current);
+        }
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        return elapsed / frames;
+    }
+
+    // the pipeline countMotionPixels replaced, as the game loop ran it
+    double benchmarkOpenCv(const Frames& inputs, int frames, std::vector<std::size_t>& counts)
+    {
+        cv::Mat depthf, oldDepth, differenceImage;
+        counts.assign(frames, 0);
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            cv::Mat depthMat(FrameHeight, FrameWidth, CV_16UC1, const_cast<uint16_t*>(&inputs[f % inputs.size()][0]));
+            depthMat.convertTo(depthf, CV_8UC1, 255.0 / 2024.0);
+            if (!oldDepth.empty())
+                cv::absdiff(oldDepth, depthf, differenceImage);
+            depthMat.convertTo(oldDepth, CV_8UC1, 255.0 / 2024.0);
+            if (f > 0) {
+                std::size_t totalWhite = 0;
+                for (int i = 0; i < differenceImage.rows; ++i) {
+                    for (int j = 0; j < differenceImage.cols; ++j) {
+                        if (differenceImage.at<uchar>(i, j) > 0)
+                            totalWhite++;
+                    }
+                }
+                counts[f] = totalWhite;
+            }
+        }
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        return elapsed / frames;
+    }
+
+    // first frame whose count differs, -1 when none
+    int findMismatch(const std::vector<std::size_t>& counts, const std::vector<std::size_t>& expected)
+    {
+        for (std::size_t f = 0; f < counts.size(); f++) {
+            if (counts[f] != expected[f])
+                return static_cast<int>(f);
+        }
+        return -1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 500;
+    std::srand(1);
+
+    Frames inputs;
+    if (argc > 2) {
+        if (!loadRecording(argv[2], inputs)) {
+            std::cout << "fail open recording " << argv[2] << std::endl;
+            return 1;
+        }
+        std::cout << "timing " << inputs.size() << " recorded frames of " << argv[2] << std::endl;
+    } else {
+        makeRandomFrames(inputs);
+        std::cout << "timing " << inputs.size() << " random frames" << std::endl;
+    }
+    std::vector<std::size_t> expected, counts;
+    std::cout << "opencv 3 pass: " << benchmarkOpenCv(inputs, frames, expected) << "us per 640x480 frame" << std::endl;
+
+    const MotionKernel kernels[] = {MotionKernelScalar, MotionKernelSSE2, MotionKernelAVX2};
+    const MotionKernel dispatched = getMotionKernel();
+    std::cout << "dispatch picks " << getName(dispatched) << std::endl;
+
+    std::vector<uint16_t> depth(MaxLength);
+    for (std::size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!setMotionKernel(kernels[k])) {
+            std::cout << getName(kernels[k]) << ": not supported, skipped" << std::endl;
+            continue;
+        }
+        for (int pattern = 0; pattern < PatternCount; pattern++) {
+            fill(depth, static_cast<Pattern>(pattern));
+            check(kernels[k], depth, static_cast<Pattern>(pattern));
+        }
+        std::cout << getName(kernels[k]) << ": " << benchmark(kernels[k], inputs, frames, counts) << "us per 640x480 frame" << std::endl;
+        int mismatch = findMismatch(counts, expected);
+        if (mismatch >= 0) {
+            failures++;
+            std::cout << "fail " << getName(kernels[k]) << " frame " << mismatch << ": " << counts[mismatch]
+                      << " changed, opencv counted " << expected[mismatch] << std::endl;
+        }
+    }
+    setMotionKernel(dispatched);
+
+    if (failures != 0) {
+        std::cout << "fail " << failures << " mismatches" << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,133 @@
+//============================================================================
+// Name        : PackResources.cpp
+// Description : offline packer writing the resources into one assets.pack
+//============================================================================
+//
+// usage: PackResources <output.pack> <file>...
+//
+// Files are stored unchanged under their name without directory, the name the
+// game asks for relative to resourcePath(). Copy the pack into the resource
+// folder; AssetPack maps it and the loaders read from it before the loose
+// files, so the pack may hold only some of them.
+//
+// build: c++ -std=c++11 -O2 -I../FazerChover PackResources.cpp ../FazerChover/AssetPack.cpp -o PackResources
+//
+// pack used by the game, from the resource folder:
+//   PackResources assets.pack animations.xml *.atlas *.png
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "AssetPack.hpp"
+
+namespace
+{
+    const std::size_t Alignment = 16;
+
+    struct Entry
+    {
+        std::string name;
+        std::vector<char> data;
+        uint64_t offset;
+    };
+
+    bool readFile(const std::string& path, std::vector<char>& data)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+        std::fseek(file, 0, SEEK_END);
+        long length = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        data.resize(length > 0 ? length : 0);
+        bool valid = length >= 0 && (data.empty() || std::fread(&data[0], data.size(), 1, file) == 1);
+        std::fclose(file);
+        return valid;
+    }
+
+    template <typename T>
+    void write(std::vector<char>& output, const T& value)
+    {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        output.insert(output.end(), bytes, bytes + sizeof(T));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "usage: " << argv[0] << " <output.pack> <file>..." << std::endl;
+        return 1;
+    }
+
+    std::string output = argv[1];
+    std::vector<Entry> entries;
+    std::set<std::string> names;
+    for (int i = 2; i < argc; ++i)
+    {
+        Entry entry;
+        std::string path = argv[i];
+        std::string::size_type slash = path.find_last_of('/');
+        entry.name = slash == std::string::npos ? path : path.substr(slash + 1);
+        entry.offset = 0;
+        if (!names.insert(entry.name).second)
+        {
+            std::cout << "duplicate name " << entry.name << std::endl;
+            return 1;
+        }
+        if (!readFile(path, entry.data))
+        {
+            std::cout << "fail load " << path << std::endl;
+            return 1;
+        }
+        entries.push_back(entry);
+    }
+
+    // header and entry table, then the data aligned
+    std::size_t tableSize = 16;
+    for (std::size_t i = 0; i < entries.size(); ++i)
+        tableSize += 20 + entries[i].name.size();
+    uint64_t offset = tableSize;
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        offset = (offset + Alignment - 1) / Alignment * Alignment;
+        entries[i].offset = offset;
+        offset += entries[i].data.size();
+    }
+
+    std::vector<char> pack;
+    pack.insert(pack.end(), AssetPack::Magic, AssetPack::Magic + sizeof(AssetPack::Magic));
+    write(pack, static_cast<uint32_t>(entries.size()));
+    write(pack, static_cast<uint32_t>(0));
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        write(pack, entries[i].offset);
+        write(pack, static_cast<uint64_t>(entries[i].data.size()));
+        write(pack, static_cast<uint32_t>(entries[i].name.size()));
+        pack.insert(pack.end(), entries[i].name.begin(), entries[i].name.end());
+    }
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        pack.resize(entries[i].offset, 0);
+        pack.insert(pack.end(), entries[i].data.begin(), entries[i].data.end());
+    }
+
+    std::FILE* file = std::fopen(output.c_str(), "wb");
+    bool written = file && (pack.empty() || std::fwrite(&pack[0], pack.size(), 1, file) == 1);
+    if (file && std::fclose(file) != 0)
+        written = false;
+    if (!written)
+    {
+        std::cout << "fail write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << entries.size() << " files, " << pack.size() << " bytes" << std::endl;
+    return 0;
+}
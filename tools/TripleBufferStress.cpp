@@ -0,0 +1,271 @@
+//============================================================================
+// Name        : TripleBufferStress.cpp
+// Description : hammers TripleBuffer from two threads, compared with a mutex
+//============================================================================
+//
+// usage: TripleBufferStress [seconds] [frames]
+//
+// Stress: for [seconds] a producer fills depth sized frames (640x480 uint16)
+// with its frame number as fast as it can while a consumer claims them and
+// checks every sample: a frame mixing two numbers is torn, a number not
+// above the previous one is a repeat. Either fails the run.
+//
+// Latency: a producer paced like the sensor (one frame every 33ms) stamps
+// each frame when it publishes it, a consumer polls for it and takes the
+// time from publish to its claim returning, [frames] frames. The same paced
+// traffic then goes through the mutex protected copy the device used before
+// (getDepth copied the frame under the lock), where the frame is published
+// when the producer's copy is done and claimed when the consumer's is.
+// Both are reported as percentiles.
+//
+// build: c++ -std=c++11 -O2 -pthread -I../FazerChover TripleBufferStress.cpp -o TripleBufferStress
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#include "TripleBuffer.hpp"
+
+namespace
+{
+    const std::size_t FrameSize = 640 * 480;
+
+    typedef std::chrono::steady_clock Clock;
+
+    // the sensor's 30Hz
+    const std::chrono::milliseconds FramePeriod(33);
+
+    struct Frame
+    {
+        std::vector<uint16_t> depth;
+        Clock::time_point published;
+    };
+
+    struct Result
+    {
+        uint64_t produced;
+        uint64_t consumed;
+        uint64_t torn;
+        uint64_t repeated;
+        std::vector<double> latencies; // microseconds, publish to claim
+    };
+
+    void fill(std::vector<uint16_t>& frame, uint64_t number)
+    {
+        std::fill(frame.begin(), frame.end(), static_cast<uint16_t>(number));
+    }
+
+    // the frame number, or -1 when the samples disagree
+    long long check(const uint16_t* frame)
+    {
+        for (std::size_t i = 1; i < FrameSize; i++) {
+            if (frame[i] != frame[0])
+                return -1;
+        }
+        return frame[0];
+    }
+
+    // numbers are 16 bit on the wire: compare modulo 2^16, the producer is
+    // never 32768 frames ahead of a consumer that checks every frame it gets
+    bool isAfter(long long number, long long previous)
+    {
+        return previous < 0 || static_cast<int16_t>(static_cast<uint16_t>(number - previous)) > 0;
+    }
+
+    void count(Result& result, const uint16_t* frame, long long& previous)
+    {
+        long long number = check(frame);
+        result.consumed++;
+        if (number < 0)
+            result.torn++;
+        else if (!isAfter(number, previous))
+            result.repeated++;
+        if (number >= 0)
+            previous = number;
+    }
+
+    double getMicroseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    Result newResult()
+    {
+        Result result = {0, 0, 0, 0, std::vector<double>()};
+        return result;
+    }
+
+    Result stressTripleBuffer(double seconds)
+    {
+        TripleBuffer<std::vector<uint16_t> > frames;
+        for (std::size_t i = 0; i < 3; i++)
+            frames.getSlot(i).assign(FrameSize, 0);
+
+        std::atomic<bool> isRunning(true);
+        Result result = newResult();
+        std::thread producer([&]() {
+            uint64_t number = 1;
+            while (isRunning) {
+                fill(frames.getBackBuffer(), number++);
+                frames.publish();
+            }
+            result.produced = number - 1;
+        });
+
+        Clock::time_point end = Clock::now() + std::chrono::microseconds(static_cast<long long>(seconds * 1e6));
+        long long previous = -1;
+        while (Clock::now() < end) {
+            if (frames.claim())
+                count(result, &frames.getFrontBuffer()[0], previous);
+        }
+        isRunning = false;
+        producer.join();
+        return result;
+    }
+
+    Result pacedTripleBuffer(int frameCount)
+    {
+        TripleBuffer<Frame> frames;
+        for (std::size_t i = 0; i < 3; i++)
+            frames.getSlot(i).depth.assign(FrameSize, 0);
+
+        Result result = newResult();
+        std::atomic<bool> isProducing(true);
+        std::thread producer([&]() {
+            Clock::time_point next = Clock::now();
+            for (int n = 1; n <= frameCount; n++) {
+                std::this_thread::sleep_until(next);
+                next += FramePeriod;
+                Frame& frame = frames.getBackBuffer();
+                fill(frame.depth, n);
+                frame.published = Clock::now();
+                frames.publish();
+            }
+            result.produced = frameCount;
+            isProducing = false;
+        });
+
+        long long previous = -1;
+        while (true) {
+            bool isLast = !isProducing;
+            if (frames.claim()) {
+                Clock::time_point claimed = Clock::now();
+                const Frame& frame = frames.getFrontBuffer();
+                result.latencies.push_back(getMicroseconds(claimed - frame.published));
+                count(result, &frame.depth[0], previous);
+            } else if (isLast) {
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        return result;
+    }
+
+    Result pacedMutex(int frameCount)
+    {
+        std::mutex mutex;
+        Frame shared;
+        shared.depth.assign(FrameSize, 0);
+        bool isNew = false;
+        std::vector<uint16_t> output(FrameSize, 0);
+
+        Result result = newResult();
+        std::atomic<bool> isProducing(true);
+        std::thread producer([&]() {
+            std::vector<uint16_t> frame(FrameSize, 0);
+            Clock::time_point next = Clock::now();
+            for (int n = 1; n <= frameCount; n++) {
+                std::this_thread::sleep_until(next);
+                next += FramePeriod;
+                fill(frame, n);
+                std::lock_guard<std::mutex> lock(mutex);
+                std::memcpy(&shared.depth[0], &frame[0], FrameSize * sizeof(uint16_t));
+                shared.published = Clock::now();
+                isNew = true;
+            }
+            result.produced = frameCount;
+            isProducing = false;
+        });
+
+        long long previous = -1;
+        while (true) {
+            bool isLast = !isProducing;
+            Clock::time_point published;
+            bool isClaimed = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (isNew) {
+                    std::memcpy(&output[0], &shared.depth[0], FrameSize * sizeof(uint16_t));
+                    published = shared.published;
+                    isNew = false;
+                    isClaimed = true;
+                }
+            }
+            if (isClaimed) {
+                result.latencies.push_back(getMicroseconds(Clock::now() - published));
+                count(result, &output[0], previous);
+            } else if (isLast) {
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        return result;
+    }
+
+    double getPercentile(const std::vector<double>& sorted, double percentile)
+    {
+        if (sorted.empty())
+            return 0;
+        std::size_t n = static_cast<std::size_t>(percentile / 100 * (sorted.size() - 1) + 0.5);
+        return sorted[n];
+    }
+
+    void report(const char* name, Result result)
+    {
+        std::cout << name << ": produced " << result.produced << " consumed " << result.consumed
+                  << " torn " << result.torn << " repeated " << result.repeated;
+        if (!result.latencies.empty()) {
+            std::vector<double>& latencies = result.latencies;
+            std::sort(latencies.begin(), latencies.end());
+            std::cout << ", publish to claim p50 " << getPercentile(latencies, 50) << "us p90 " << getPercentile(latencies, 90)
+                      << "us p99 " << getPercentile(latencies, 99) << "us max " << latencies.back() << "us";
+        }
+        std::cout << std::endl;
+    }
+
+    bool isClean(const Result& result)
+    {
+        return result.consumed != 0 && result.torn == 0 && result.repeated == 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 300;
+
+    Result stress = stressTripleBuffer(seconds);
+    report("triple buffer, flat out", stress);
+    Result triple = pacedTripleBuffer(frames);
+    report("triple buffer, 30Hz    ", triple);
+    Result locked = pacedMutex(frames);
+    report("mutex copy, 30Hz       ", locked);
+
+    if (!isClean(stress) || !isClean(triple)) {
+        std::cout << "fail triple buffer handoff" << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}